@@ -0,0 +1,67 @@
+#include "async_executor.hh"
+#include "converter.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+struct counters_t {
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> failed{ 0 };
+    std::atomic<size_t> bytes{ 0 };
+    std::atomic<size_t> in_flight{ 0 };
+    std::atomic<size_t> peak{ 0 };
+};
+
+static task<void> worker(async_executor& executor, counters_t& counters, size_t commands) {
+    while (counters.next.fetch_add(1) < commands) {
+        size_t now = counters.in_flight.fetch_add(1) + 1;
+        size_t peak = counters.peak.load();
+        while (now > peak && !counters.peak.compare_exchange_weak(peak, now)) { }
+
+        command_result_t result = co_await executor.run(convert("dir /b /"));
+        counters.in_flight.fetch_sub(1);
+        if (result.status != 0 || result.output.empty()) {
+            counters.failed.fetch_add(1);
+        }
+        counters.bytes.fetch_add(result.output.size());
+    }
+}
+
+static void measure(size_t commands, size_t concurrency, unsigned int threads) {
+    reactor r;
+    async_executor executor(r);
+    counters_t counters;
+    for (size_t i = 0; i < concurrency; i++) {
+        r.spawn(worker(executor, counters, commands));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> runners;
+    for (unsigned int t = 1; t < threads; t++) {
+        runners.emplace_back([&r] { r.run(); });
+    }
+    r.run();
+    for (auto& t : runners) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::setw(8) << concurrency << std::setw(9) << threads
+              << std::fixed << std::setprecision(0) << std::setw(12) << commands / seconds
+              << std::setw(8) << counters.peak.load() << std::setw(8) << counters.failed.load() << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t commands = argc > 1 ? std::stoul(argv[1]) : 5000;
+    std::cout << "concurr. threads      cmd/s    peak  failed" << std::endl;
+    for (size_t concurrency : { 1, 16, 256, 2048 }) {
+        for (unsigned int threads : { 1u, 4u }) {
+            measure(commands, concurrency, threads);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "codec.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+
+static std::string make_listing(size_t size) {
+    std::mt19937 rng(42);
+    const char* dirs[] = { "src", "include", "lib", "var/log", "usr/share/doc" };
+    const char* exts[] = { ".cc", ".hh", ".o", ".log", ".txt" };
+    std::string res;
+    while (res.size() < size) {
+        res += "-rw-r--r-- 1 user user ";
+        res += std::to_string(rng() % 100000);
+        res += " 2024-01-";
+        res += std::to_string(10 + rng() % 20);
+        res += " ";
+        res += dirs[rng() % 5];
+        res += "/file_";
+        res += std::to_string(rng() % 10000);
+        res += exts[rng() % 5];
+        res += "\n";
+    }
+    res.resize(size);
+    return res;
+}
+
+static std::string make_random(size_t size) {
+    std::mt19937 rng(7);
+    std::string res(size, '\0');
+    for (auto& c : res) {
+        c = (char)rng();
+    }
+    return res;
+}
+
+static void run(const char* name, const std::string& input, int level) {
+    compressor comp(codec_type::zlib, level);
+    decompressor decomp(codec_type::zlib);
+    std::vector<char> frame;
+    std::vector<char> raw;
+    size_t out_size = 0;
+
+    std::clock_t cpu_start = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < input.size(); pos += PIPE_BUFFER_SIZE) {
+        size_t chunk = std::min<size_t>(PIPE_BUFFER_SIZE, input.size() - pos);
+        if (comp.compress(input.data() + pos, chunk, frame) != codec_type::none) {
+            out_size += frame.size();
+        } else {
+            out_size += chunk;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    std::cout << std::left << std::setw(10) << name << " level " << level
+              << std::fixed << std::setprecision(1)
+              << "  ratio " << std::setw(6) << double(input.size()) / out_size
+              << "  " << std::setw(8) << input.size() / seconds / (1 << 20) << " MB/s"
+              << "  cpu " << std::setprecision(3) << cpu * 1e9 / input.size() << " ns/byte" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t size = argc > 1 ? std::stoul(argv[1]) : 64 << 20;
+    std::string listing = make_listing(size);
+    std::string random = make_random(size);
+    for (int level = 1; level <= 3; level++) {
+        run("listing", listing, level);
+        run("random", random, level);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "converter.hh"
+#include "../test/reference_converter.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Typical interactive traffic: mostly pass-through commands, some dir
+// listings with flags, the odd cd/move/del.
+static const std::vector<std::string> CORPUS = {
+    "dir", "dir /b", "dir /s /b", "dir /a /on C:\\Users", "dir /S /O-D build", "cd", "cd ..", "cd src/include",
+    "move a.txt b.txt", "rename old new", "del *.o", "ls -la", "make -j8", "git status", "echo hello world",
+    "cat README.md", "grep -rn TODO src", "dir /b /s *.cc *.hh", "cd   ", "python3 script.py --input data.csv"
+};
+
+template <class Fn>
+static void measure(const char* name, const std::vector<std::string>& corpus, size_t rounds, Fn fn) {
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (auto& command : corpus) {
+            bytes += fn(command).size();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double commands = static_cast<double>(rounds * corpus.size());
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << commands / seconds / 1e6 << " Mcmd/s  "
+              << std::setw(6) << seconds * 1e9 / commands << " ns/cmd  (" << bytes << " bytes out)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t rounds = argc > 1 ? std::stoul(argv[1]) : 50000;
+    std::vector<std::string> corpus = CORPUS;
+    // an optional file of extra commands, one per line
+    if (argc > 2) {
+        std::ifstream file(argv[2]);
+        std::string line;
+        while (std::getline(file, line)) {
+            corpus.push_back(line);
+        }
+    }
+
+    for (auto& command : corpus) {
+        for (bool cmd_format : { false, true }) {
+            if (convert(command, cmd_format) != reference_convert(command, cmd_format)) {
+                std::cerr << "Output differs from the reference on '" << command << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    for (bool cmd_format : { false, true }) {
+        std::cout << (cmd_format ? "cmd format:" : "raw format:") << std::endl;
+        measure("reference", corpus, rounds, [cmd_format](const std::string& c) { return reference_convert(c, cmd_format); });
+        converter conv(cmd_format);
+        measure("converter", corpus, rounds, [&conv](const std::string& c) { return conv.convert(c); });
+    }
+    return 0;
+}
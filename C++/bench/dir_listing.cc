@@ -0,0 +1,79 @@
+#include "dir_lister.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static void make_tree(const std::string& root, size_t files, size_t per_dir) {
+    if (access((root + "/.complete").c_str(), F_OK) == 0) {
+        return;
+    }
+    std::cout << "Creating " << files << " files under " << root << "..." << std::endl;
+    mkdir(root.c_str(), 0755);
+    size_t dirs = (files + per_dir - 1) / per_dir;
+    for (size_t d = 0; d < dirs; d++) {
+        std::string outer = root + "/d" + std::to_string(d % 100);
+        std::string dir = outer + "/s" + std::to_string(d / 100);
+        mkdir(outer.c_str(), 0755);
+        mkdir(dir.c_str(), 0755);
+        for (size_t f = 0; f < per_dir && d * per_dir + f < files; f++) {
+            int fd = open((dir + "/file_" + std::to_string(f) + ".txt").c_str(), O_CREAT | O_WRONLY, 0644);
+            close(fd);
+        }
+    }
+    close(open((root + "/.complete").c_str(), O_CREAT | O_WRONLY, 0644));
+}
+
+template <class Fn>
+static void measure(const char* name, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    size_t bytes = fn();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(24) << name << std::fixed << std::setprecision(3)
+              << seconds << " s  " << bytes / (1 << 20) << " MiB" << std::endl;
+}
+
+static size_t run_native(const std::string& root, const char* flags, unsigned int threads) {
+    dir_options_t options;
+    dir_lister::parse(std::string("ls ") + flags + " " + root, options);
+    dir_lister lister(options, threads);
+    size_t bytes = 0;
+    lister.run([&bytes](const char*, size_t size) {
+        bytes += size;
+        return true;
+    });
+    return bytes;
+}
+
+static size_t run_shell(const std::string& command) {
+    FILE *fp = popen(command.c_str(), "r");
+    char buf[65536];
+    size_t bytes = 0, size;
+    while ((size = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        bytes += size;
+    }
+    pclose(fp);
+    return bytes;
+}
+
+int main(int argc, char *argv[]) {
+    std::string root = argc > 1 ? argv[1] : "/tmp/dir_listing_bench";
+    size_t files = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    make_tree(root, files, 1000);
+
+    measure("ls -R", [&] { return run_shell("ls -R " + root); });
+    measure("ls -RU", [&] { return run_shell("ls -RU " + root); });
+    measure("find", [&] { return run_shell("find " + root); });
+    measure("ls -lR", [&] { return run_shell("ls -lR " + root); });
+    for (unsigned int threads : { 1u, 0u }) {
+        std::string suffix = threads ? " (1 thread)" : " (all cores)";
+        measure(("native -R" + suffix).c_str(), [&] { return run_native(root, "-R", threads); });
+        measure(("native -RU" + suffix).c_str(), [&] { return run_native(root, "-RU", threads); });
+        measure(("native -lR" + suffix).c_str(), [&] { return run_native(root, "-lR", threads); });
+    }
+    return 0;
+}
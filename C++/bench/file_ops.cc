@@ -0,0 +1,76 @@
+#include "file_ops.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static void make_files(const std::string& dir, size_t files) {
+    mkdir(dir.c_str(), 0755);
+    for (size_t i = 0; i < files; i++) {
+        close(open((dir + "/file_" + std::to_string(i) + ".txt").c_str(), O_CREAT | O_WRONLY, 0644));
+    }
+}
+
+template <class Fn>
+static void measure(const char* name, size_t files, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = fn();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(28) << name << std::fixed << std::setprecision(3)
+              << seconds << " s  " << std::setprecision(0) << files / seconds << " files/s"
+              << (ok ? "" : "  (failed)") << std::endl;
+}
+
+static bool run_native(const std::string& command, bool use_uring) {
+    file_ops_options_t options;
+    if (!file_ops::parse(command, options)) {
+        return false;
+    }
+    file_ops engine(options, FILE_OPS_BATCH_SIZE, FILE_OPS_THREADS, use_uring);
+    bool clean = true;
+    engine.run([&clean](const char*, size_t) {
+        clean = false;
+        return true;
+    });
+    return clean;
+}
+
+static bool run_shell(const std::string& command) {
+    return system((command + " 2>/dev/null").c_str()) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::string root = argc > 1 ? argv[1] : "/tmp/file_ops_bench";
+    size_t files = argc > 2 ? std::stoul(argv[2]) : 100000;
+    std::string src = root + "/src";
+    std::string dst = root + "/dst";
+    mkdir(root.c_str(), 0755);
+    mkdir(dst.c_str(), 0755);
+
+    make_files(src, files);
+    measure("rm (shell glob)", files, [&] { return run_shell("rm -f " + src + "/*"); });
+    make_files(src, files);
+    measure("find -delete", files, [&] { return run_shell("find " + src + " -type f -delete"); });
+    make_files(src, files);
+    measure("native rm (io_uring)", files, [&] { return run_native("rm " + src + "/*", true); });
+    make_files(src, files);
+    measure("native rm (threads)", files, [&] { return run_native("rm " + src + "/*", false); });
+
+    make_files(src, files);
+    measure("mv (shell glob)", files, [&] { return run_shell("mv " + src + "/* " + dst); });
+    run_shell("find " + dst + " -type f -delete");
+    make_files(src, files);
+    measure("find -exec mv", files, [&] { return run_shell("find " + src + " -type f -exec mv -t " + dst + " {} +"); });
+    run_shell("find " + dst + " -type f -delete");
+    make_files(src, files);
+    measure("native mv (io_uring)", files, [&] { return run_native("mv " + src + "/* " + dst, true); });
+    run_shell("find " + dst + " -type f -delete");
+    make_files(src, files);
+    measure("native mv (threads)", files, [&] { return run_native("mv " + src + "/* " + dst, false); });
+    run_shell("rm -rf " + root);
+    return 0;
+}
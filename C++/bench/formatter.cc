@@ -0,0 +1,58 @@
+#include "dir_formatter.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+// Synthetic `ls -lR --time-style=long-iso` output with 1000 entries per directory.
+static std::string make_listing(size_t lines) {
+    std::string listing;
+    listing.reserve(lines * 72);
+    size_t dir = 0;
+    for (size_t i = 0; i < lines; dir++) {
+        listing += "./d" + std::to_string(dir) + ":\ntotal 4000\n";
+        for (size_t f = 0; f < 1000 && i < lines; f++, i++) {
+            if (f % 10 == 0) {
+                listing += "drwxr-xr-x 2 root root       4096 2026-10-19 12:00 sub_" + std::to_string(f) + "\n";
+            } else {
+                listing += "-rw-r--r-- 1 root root " + std::to_string(f * 7919 % 10000000)
+                         + " 2026-10-19 12:00 file_" + std::to_string(f) + ".txt\n";
+            }
+        }
+        listing += "\n";
+    }
+    return listing;
+}
+
+static void measure(const char* name, const std::string& listing, size_t lines, size_t chunk) {
+    dir_options_t options;
+    options.recursive = true;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    dir_formatter formatter(options, [&bytes](const char*, size_t size) {
+        bytes += size;
+        return true;
+    });
+    for (size_t pos = 0; pos < listing.size(); pos += chunk) {
+        formatter.feed(listing.data() + pos, std::min(chunk, listing.size() - pos));
+    }
+    formatter.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(20) << name << std::fixed << std::setprecision(3)
+              << seconds << " s  " << std::setprecision(1)
+              << listing.size() / seconds / (1 << 20) << " MiB/s in  "
+              << lines / seconds / 1e6 << " Mlines/s  " << bytes / (1 << 20) << " MiB out" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 4000000;
+    std::string listing = make_listing(lines);
+    std::cout << "Formatting " << lines << " entries (" << listing.size() / (1 << 20) << " MiB)" << std::endl;
+
+    measure("chunk 4 KiB", listing, lines, 4096);
+    measure("chunk 32 KiB", listing, lines, PIPE_BUFFER_SIZE);
+    measure("chunk 1 MiB", listing, lines, 1 << 20);
+    return 0;
+}
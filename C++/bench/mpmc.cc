@@ -0,0 +1,58 @@
+#include "message_queue.hh"
+#include "memory_transport.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <sys/ipc.h>
+
+static double run(transport& tr, unsigned int threads, size_t messages) {
+    size_t per_producer = messages / threads;
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&tr] {
+            while (std::get<1>(tr.receive(session_request_type(0))) != "stop") { }
+        });
+    }
+    std::vector<std::thread> producers;
+    for (unsigned int t = 0; t < threads; t++) {
+        producers.emplace_back([&tr, per_producer, t] {
+            for (size_t i = 0; i < per_producer; i++) {
+                tr.send(session_request_type(0), "ls -l", t);
+            }
+        });
+    }
+    for (auto& p : producers) {
+        p.join();
+    }
+    for (unsigned int t = 0; t < threads; t++) {
+        tr.send(session_request_type(0), "stop");
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return per_producer * threads / seconds;
+}
+
+int main(int argc, char *argv[]) {
+    size_t messages = argc > 1 ? std::stoul(argv[1]) : 200000;
+    std::cout << std::left << std::setw(10) << "threads" << std::right
+              << std::setw(16) << "msgsnd msg/s" << std::setw(16) << "mpmc msg/s" << std::endl;
+    for (unsigned int threads : { 1u, 2u, 4u, 8u, 16u, 32u, 64u }) {
+        message_queue msq(IPC_PRIVATE);
+        double sysv = run(msq, threads, messages);
+        msq.destroy();
+
+        memory_transport mem;
+        double ring = run(mem, threads, messages);
+
+        std::cout << std::left << std::setw(10) << threads << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << sysv << std::setw(16) << ring << std::endl;
+    }
+    return 0;
+}
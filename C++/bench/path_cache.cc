@@ -0,0 +1,169 @@
+#include "path_cache.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <csignal>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+
+static const char* BENCH_DIR = "/tmp/lcc_path_bench";
+static const int EMPTY_DIRS = 40;
+
+struct syscall_count_t {
+    size_t total = 0;
+    size_t failed = 0;
+};
+
+static void exec_argv(const std::vector<const char*>& argv, char* const* envp) {
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    execve(argv[0], const_cast<char* const*>(argv.data()), envp);
+    _exit(127);
+}
+
+// Counts the syscalls made by the exec'd program and every process it forks.
+static bool count_syscalls(const std::vector<const char*>& argv, char* const* envp, syscall_count_t& count) {
+    pid_t child = fork();
+    if (child == 0) {
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        raise(SIGSTOP);
+        exec_argv(argv, envp);
+    }
+    int stat;
+    waitpid(child, &stat, 0);
+    if (!WIFSTOPPED(stat)) {
+        return false;
+    }
+    if (ptrace(PTRACE_SETOPTIONS, child, nullptr,
+               PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK | PTRACE_O_TRACECLONE) == -1) {
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+        return false;
+    }
+    std::map<pid_t, bool> in_syscall;
+    ptrace(PTRACE_SYSCALL, child, nullptr, nullptr);
+    size_t alive = 1;
+    while (alive > 0) {
+        pid_t pid = waitpid(-1, &stat, __WALL);
+        if (pid == -1) {
+            break;
+        }
+        if (WIFEXITED(stat) || WIFSIGNALED(stat)) {
+            alive--;
+            continue;
+        }
+        int signal = 0;
+        if (WSTOPSIG(stat) == (SIGTRAP | 0x80)) {
+            bool& entering = in_syscall[pid];
+            entering = !entering;
+            if (entering) {
+                count.total++;
+            }
+#if defined(__x86_64__)
+            else {
+                user_regs_struct regs;
+                ptrace(PTRACE_GETREGS, pid, nullptr, &regs);
+                if ((long)regs.rax < 0 && (long)regs.rax > -4096) {
+                    count.failed++;
+                }
+            }
+#endif
+        }
+        else if ((stat >> 16) == PTRACE_EVENT_FORK || (stat >> 16) == PTRACE_EVENT_VFORK ||
+                 (stat >> 16) == PTRACE_EVENT_CLONE) {
+            alive++;
+        }
+        else if (WSTOPSIG(stat) != SIGTRAP && WSTOPSIG(stat) != SIGSTOP) {
+            signal = WSTOPSIG(stat);
+        }
+        ptrace(PTRACE_SYSCALL, pid, nullptr, signal);
+    }
+    return true;
+}
+
+template <class Fn>
+static double per_call_us(size_t runs, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; i++) {
+        fn();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+static void spawn_wait(const std::vector<const char*>& argv, char* const* envp) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    if (posix_spawn(&pid, argv[0], &actions, nullptr, const_cast<char* const*>(argv.data()), envp) == 0) {
+        waitpid(pid, nullptr, 0);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+}
+
+int main(int argc, char *argv[]) {
+    size_t runs = argc > 1 ? std::stoul(argv[1]) : 200;
+
+    // a long PATH with the real directories at the end, as on a cluttered login
+    mkdir(BENCH_DIR, 0755);
+    std::string path;
+    for (int i = 0; i < EMPTY_DIRS; i++) {
+        std::string dir = std::string(BENCH_DIR) + "/d" + std::to_string(i);
+        mkdir(dir.c_str(), 0755);
+        path += dir + ":";
+    }
+    const char* real = getenv("PATH");
+    path += real ? real : "/usr/bin:/bin";
+    setenv("PATH", path.c_str(), 1);
+
+    path_cache cache(path.c_str());
+    std::string command = "ls /";
+    std::vector<std::string> args;
+    path_cache::simple_command(command, args);
+
+    double cold = per_call_us(1, [&] { cache.resolve(args.front()); });
+    double warm = per_call_us(runs * 100, [&] { cache.resolve(args.front()); });
+    std::string program = cache.resolve(args.front());
+    if (program.empty()) {
+        std::cerr << "ls not found in PATH" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "PATH entries: " << EMPTY_DIRS << " empty + real" << std::endl;
+    std::cout << "resolve '" << args.front() << "' -> " << program << ": cold "
+              << std::fixed << std::setprecision(2) << cold << " us (" << cache.total_probes() << " probes), warm "
+              << warm << " us" << std::endl;
+
+    std::vector<const char*> shell = { EXECUTOR_SHELL, "-c", command.c_str(), nullptr };
+    std::vector<const char*> direct;
+    direct.push_back(program.c_str());
+    for (size_t i = 1; i < args.size(); i++) {
+        direct.push_back(args[i].c_str());
+    }
+    direct.push_back(nullptr);
+
+    syscall_count_t via_shell, via_cache;
+    if (count_syscalls(shell, cache.envp(), via_shell) && count_syscalls(direct, cache.envp(), via_cache)) {
+        std::cout << std::setw(10) << "" << std::setw(10) << "syscalls" << std::setw(10) << "failed" << std::endl;
+        std::cout << std::left << std::setw(10) << "sh -c" << std::right << std::setw(10) << via_shell.total
+                  << std::setw(10) << via_shell.failed << std::endl;
+        std::cout << std::left << std::setw(10) << "cached" << std::right << std::setw(10) << via_cache.total
+                  << std::setw(10) << via_cache.failed << std::endl;
+    }
+    else {
+        std::cout << "ptrace unavailable, skipping syscall counts" << std::endl;
+    }
+
+    std::cout << std::setprecision(0)
+              << "spawn+wait sh -c: " << per_call_us(runs, [&] { spawn_wait(shell, cache.envp()); }) << " us" << std::endl
+              << "spawn+wait cached: " << per_call_us(runs, [&] { spawn_wait(direct, cache.envp()); }) << " us" << std::endl;
+    return 0;
+}
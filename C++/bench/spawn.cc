@@ -0,0 +1,113 @@
+#include "executor_pool.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+static const char* COMMAND = "echo hello";
+
+static void drain(FILE* fp) {
+    char buf[4096];
+    while (fread(buf, 1, sizeof(buf), fp) > 0) { }
+}
+
+static void run_popen() {
+    FILE *fp = popen(COMMAND, "r");
+    if (!fp) {
+        perror("popen");
+        return;
+    }
+    drain(fp);
+    pclose(fp);
+}
+
+static void run_posix_spawn() {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        return;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    char *argv[] = { (char *)"sh", (char *)"-c", (char *)COMMAND, nullptr };
+    pid_t pid;
+    int res = posix_spawn(&pid, EXECUTOR_SHELL, &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    FILE *fp = fdopen(fds[0], "r");
+    drain(fp);
+    fclose(fp);
+    if (res == 0) {
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+template <class Fn>
+static void measure(const char* name, unsigned int threads, size_t runs, Fn fn) {
+    std::vector<std::vector<double>> latencies(threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < runs; i++) {
+                auto begin = std::chrono::steady_clock::now();
+                fn();
+                latencies[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto& l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+    std::cout << std::left << std::setw(12) << name << std::right << std::setw(3) << threads << " threads  "
+              << std::fixed << std::setprecision(0)
+              << "p50 " << std::setw(6) << all[all.size() / 2] << " us  "
+              << "p99 " << std::setw(6) << all[all.size() * 99 / 100] << " us  "
+              << std::setw(7) << all.size() / seconds << " cmd/s" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t runs = argc > 1 ? std::stoul(argv[1]) : 200;
+
+    executor_pool pool([](const std::string& command, const std::string&) {
+        execl(EXECUTOR_SHELL, "sh", "-c", command.c_str(), (char *)nullptr);
+    });
+    if (!pool.start()) {
+        perror("executor_pool");
+        return EXIT_FAILURE;
+    }
+
+    for (unsigned int threads : { 1u, 4u, 16u }) {
+        measure("popen", threads, runs, run_popen);
+        measure("posix_spawn", threads, runs, run_posix_spawn);
+        pool.resize(threads);
+        measure("pool", threads, runs, [&pool] {
+            FILE *fp = pool.run(COMMAND);
+            if (!fp) {
+                perror("executor_pool::run");
+                return;
+            }
+            drain(fp);
+            fclose(fp);
+        });
+    }
+    return 0;
+}
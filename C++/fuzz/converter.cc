@@ -0,0 +1,37 @@
+#include "converter.hh"
+#include "../test/reference_converter.hh"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+// Differential fuzz target: any divergence from the reference aborts.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    std::string command(reinterpret_cast<const char *>(data), size);
+    for (bool cmd_format : { false, true }) {
+        if (convert(command, cmd_format) != reference_convert(command, cmd_format)) {
+            abort();
+        }
+    }
+    return 0;
+}
+
+#ifndef LIBFUZZER
+// Standalone driver for AFL and for replaying crashes: runs each file
+// argument, or stdin when there is none.
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::string input((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+        return LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+    }
+    for (int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+    }
+    return 0;
+}
+#endif
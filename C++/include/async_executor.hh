@@ -0,0 +1,46 @@
+#ifndef __ASYNC_EXECUTOR_HH__
+#define __ASYNC_EXECUTOR_HH__
+
+#include <string>
+#include <memory>
+#include <sys/types.h>
+
+#include "definations.hh"
+#include "reactor.hh"
+#include "task.hh"
+
+typedef struct _command_result {
+    int status = -1;
+    std::string output;
+} command_result_t;
+
+// A spawned command whose stdout is read through the reactor. Destroying it
+// before wait() kills the command and reaps it through the reactor.
+class async_process {
+private:
+    reactor& r;
+    pid_t pid;
+    int pid_fd;
+    byte_stream out;
+public:
+    async_process(reactor& r, pid_t pid, int out_fd);
+    async_process(const async_process& other) = delete;
+    ~async_process();
+
+    byte_stream& output() { return out; }
+    task<int> wait();
+};
+
+// Library entry point: co_await executor.run(convert("dir /s")) from any
+// coroutine spawned on the reactor.
+class async_executor {
+private:
+    reactor& r;
+public:
+    async_executor(reactor& r);
+
+    std::unique_ptr<async_process> spawn(const std::string& command);
+    task<command_result_t> run(std::string command);
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef __BACKEND_HH__
+#define __BACKEND_HH__
+
+#include <signal.h>
+
+#include "transport.hh"
+
+// Serves requests from the transport until an exit message arrives or
+// `stop` is set, then hands the requests it has not run back to the
+// transport.
+void backend(transport& msq, bool verbose = false, const volatile sig_atomic_t* stop = nullptr);
+
+#endif
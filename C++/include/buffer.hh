@@ -7,20 +7,20 @@ private:
     _data_type* pdata;
 public:
     template <class ...Args>
-    buffer<_data_type>(Args ...args) {
+    buffer(Args ...args) {
         pdata = new _data_type(args...);
     }
 
-    buffer<_data_type>(const buffer<_data_type>& other) {
+    buffer(const buffer<_data_type>& other) {
         pdata = new _data_type(*(other.pdata));
     }
 
-    buffer<_data_type>(buffer<_data_type>&& other) {
+    buffer(buffer<_data_type>&& other) {
         pdata = other.pdata;
         other.pdata = nullptr;
     }
 
-    ~buffer<_data_type>() {
+    ~buffer() {
         if (pdata) {
             delete pdata;
         }
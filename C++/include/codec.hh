@@ -0,0 +1,65 @@
+#ifndef __CODEC_HH__
+#define __CODEC_HH__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <zlib.h>
+
+#include "definations.hh"
+
+enum class codec_type : uint32_t {
+    none = 0,
+    zlib = 1
+};
+
+codec_type codec_from_name(const std::string& name);
+const char* codec_name(codec_type type);
+
+typedef struct _frame_header {
+    uint32_t codec;
+    uint32_t raw_size;
+    uint32_t size;
+} frame_header_t;
+
+// frame_header_t::codec of a frame that carries uncompressed text about the
+// command, such as its counters, rather than output
+constexpr const uint32_t FRAME_TRAILER = 0xffffffff;
+
+// One deflate stream per command. Every frame ends on a sync flush, so the
+// reader can inflate it on arrival while later frames still refer back to
+// earlier ones. A frame that is sent raw resets the writer's history, which
+// the reader never saw; reset() starts the next command afresh.
+class compressor {
+private:
+    codec_type type;
+    z_stream stream;
+    unsigned int skip_frames;
+    unsigned long long bytes_in;
+    unsigned long long bytes_out;
+public:
+    compressor(codec_type type, int level = COMPRESSION_LEVEL);
+    compressor(const compressor& other) = delete;
+    ~compressor();
+
+    codec_type compress(const char* data, size_t size, std::vector<char>& out);
+    void reset();
+
+    unsigned long long total_in() const { return bytes_in; }
+    unsigned long long total_out() const { return bytes_out; }
+};
+
+class decompressor {
+private:
+    codec_type type;
+    z_stream stream;
+public:
+    decompressor(codec_type type);
+    decompressor(const decompressor& other) = delete;
+    ~decompressor();
+
+    bool decompress(const char* data, size_t size, size_t raw_size, std::vector<char>& out);
+    void reset();
+};
+
+#endif
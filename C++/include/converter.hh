@@ -5,18 +5,28 @@
 #include <vector>
 #include <tuple>
 #include <string>
+#include <string_view>
 #include <functional>
 
+#include "path_translator.hh"
+
 class converter {
 private:
-    std::map<std::string, std::function<std::string (std::string, std::string)>> command_map;
+    std::map<std::string, std::function<std::string (std::string_view, std::string_view)>, std::less<>> command_map;
+    bool cmd_format;
+    path_translator* paths;
 
-    std::tuple<std::string, std::string> get_command(std::string command);
+    std::string translate_args(std::string_view args);
+    static std::tuple<std::string_view, std::string_view> get_command(std::string_view command);
 public:
-    converter();
+    // paths, when given, turns cmd-style path arguments into real paths
+    converter(bool cmd_format = false, path_translator* paths = nullptr);
 
     void initialize();
-    std::string convert(std::string command);
+    std::string convert(const std::string& command);
 };
 
+// Converts with a per-thread converter; safe to call from any thread.
+std::string convert(const std::string& command, bool cmd_format = false);
+
 #endif
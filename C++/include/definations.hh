@@ -2,7 +2,32 @@
 #define __DEFINATIONS_HH__
 
 constexpr const unsigned int MESSAGE_DATA_SIZE = 256;
-constexpr const unsigned int PIPE_BUFFER_SIZE = 1024;
+constexpr const unsigned int PIPE_BUFFER_SIZE = 32768;
+
+constexpr const int COMPRESSION_LEVEL = 1;
+constexpr const unsigned int COMPRESSION_MIN_SIZE = 512;
+constexpr const unsigned int COMPRESSION_MIN_SAVING_PERCENT = 10;
+constexpr const unsigned int COMPRESSION_BACKOFF_FRAMES = 16;
+
+constexpr const unsigned int DIR_LISTER_THREADS = 0;
+constexpr const unsigned int DIR_LISTER_BATCH_SIZE = 65536;
+constexpr const unsigned int DIR_LISTER_GETDENTS_SIZE = 65536;
+constexpr const unsigned int DIR_LISTER_PARALLEL_SORT_MIN = 65536;
+// directories listed ahead of the output; bounds the memory held in blocks
+constexpr const unsigned int DIR_LISTER_WINDOW = 64;
+
+constexpr const unsigned int FILE_OPS_BATCH_SIZE = 256;
+constexpr const unsigned int FILE_OPS_THREADS = 0;
+
+constexpr const unsigned int EXECUTOR_POOL_MIN = 2;
+constexpr const unsigned int EXECUTOR_POOL_MAX = 16;
+constexpr const auto EXECUTOR_SHELL = "/bin/sh";
+
+constexpr const unsigned int CACHE_LINE_SIZE = 64;
+constexpr const unsigned int MEMORY_TRANSPORT_CAPACITY = 256;
+constexpr const unsigned int MEMORY_TRANSPORT_CHANNELS = 64;
+constexpr const unsigned int MEMORY_TRANSPORT_SPIN_MIN = 16;
+constexpr const unsigned int MEMORY_TRANSPORT_SPIN_MAX = 4096;
 
 constexpr const auto NAMED_PIPE_PATH = "/tmp/mypipe";
 constexpr const auto BACKEND_PATH = "./backend";
@@ -10,10 +35,39 @@ constexpr const auto BACKEND_NAME = "backend";
 constexpr const int MESSAGE_QUEUE_KEY = 0x12345678;
 
 constexpr const long MESSAGE_TYPE_EXIT = 1;
-constexpr const long MESSAGE_TYPE_REQUEST = 2;
-constexpr const long MESSAGE_TYPE_BACKEND_ACCEPTABLE = -2;
-constexpr const long MESSAGE_TYPE_RESPONSE = 3;
-constexpr const long MESSAGE_TYPE_READY = 4;
+constexpr const long MESSAGE_TYPE_SESSION = 2;
+// Requests are typed per session (base + session id) so a frontend can take
+// back its own queued request. Frontend session ids are pids, below
+// PID_MAX_LIMIT; replay sessions are numbered above it (see replay_session).
+constexpr const long MESSAGE_TYPE_REQUEST_BASE = 3;
+constexpr const long MESSAGE_PID_MAX = 4194304;
+constexpr const long MESSAGE_SESSION_MAX = MESSAGE_PID_MAX + (MESSAGE_PID_MAX << 8);
+constexpr const long MESSAGE_TYPE_BACKEND_ACCEPTABLE = -(MESSAGE_TYPE_REQUEST_BASE + MESSAGE_SESSION_MAX);
+constexpr const long MESSAGE_TYPE_RESPONSE = -MESSAGE_TYPE_BACKEND_ACCEPTABLE + 1;
+constexpr const long MESSAGE_TYPE_READY = -MESSAGE_TYPE_BACKEND_ACCEPTABLE + 2;
+constexpr const long MESSAGE_TYPE_SESSION_BASE = -MESSAGE_TYPE_BACKEND_ACCEPTABLE + 16;
+
+constexpr const unsigned int SUPERVISOR_BACKOFF_MIN_MS = 100;
+constexpr const unsigned int SUPERVISOR_BACKOFF_MAX_MS = 5000;
+constexpr const unsigned int SUPERVISOR_MAX_RESTARTS = 5;
+constexpr const unsigned int SUPERVISOR_POLL_MS = 10;
+constexpr const auto SUPERVISOR_LOST_MESSAGE = "!backend-lost";
+
+constexpr const unsigned int SCHEDULER_QUANTUM = 4;
+constexpr const unsigned int SCHEDULER_BATCH_COST = 4;
+// heavy commands running at once across every backend on the host
+constexpr const unsigned int SCHEDULER_MAX_HEAVY = 1;
+constexpr const int SCHEDULER_HEAVY_KEY = MESSAGE_QUEUE_KEY + 1;
+// how often a backend left with only capped heavy work looks for a free slot
+constexpr const unsigned int SCHEDULER_HEAVY_POLL_MS = 10;
+constexpr const unsigned int SCHEDULER_BATCH_MAX_WAIT_MS = 2000;
+
+// drive letters (C:\...) all map to this directory
+constexpr const auto PATH_DRIVE_ROOT = "/";
+constexpr const unsigned int PATH_TRANSLATOR_MAX_DIRS = 256;
+
+// replay sessions are numbered in the low 8 bits of the session id
+constexpr const unsigned int REPLAY_MAX_CONCURRENCY = 255;
 
 constexpr const auto PROMPT = "$";
 
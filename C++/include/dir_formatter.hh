@@ -0,0 +1,60 @@
+#ifndef __DIR_FORMATTER_HH__
+#define __DIR_FORMATTER_HH__
+
+#include <string>
+#include <functional>
+
+#include "definations.hh"
+#include "dir_lister.hh"
+
+enum class output_format {
+    raw = 0,
+    cmd = 1
+};
+
+output_format output_format_from_name(const std::string& name);
+const char* output_format_name(output_format format);
+
+// Streams `ls -l --time-style=long-iso` output (from ls or dir_lister)
+// into cmd `dir` layout, one line at a time.
+class dir_formatter {
+public:
+    using sink_t = std::function<bool (const char*, size_t)>;
+
+    static bool detect(const std::string& command, dir_options_t& options);
+private:
+    struct counts {
+        unsigned long long files = 0;
+        unsigned long long bytes = 0;
+        unsigned long long dirs = 0;
+    };
+
+    sink_t sink;
+    bool recursive;
+    std::string cwd;
+    std::string first_dir;
+    std::string line;
+    std::string out;
+    counts dir_counts;
+    counts total_counts;
+    bool in_dir;
+    bool block_start;
+    size_t listed_dirs;
+    bool connected;
+
+    void process_line(const char* begin, const char* end);
+    void open_dir(const char* path, size_t size);
+    void close_dir();
+    bool format_entry(const char* begin, const char* end);
+    void append_number(unsigned long long value, int width);
+    void append_summary(unsigned long long count, const char* label, unsigned long long bytes, int width, const char* suffix);
+    bool flush(bool force);
+public:
+    dir_formatter(const dir_options_t& options, sink_t sink);
+    dir_formatter(const dir_formatter& other) = delete;
+
+    bool feed(const char* data, size_t size);
+    bool finish();
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __DIR_LISTER_HH__
+#define __DIR_LISTER_HH__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <sys/types.h>
+
+#include "definations.hh"
+
+enum class dir_sort {
+    none,
+    name,
+    size,
+    time,
+    extension
+};
+
+typedef struct _dir_options {
+    bool recursive = false;
+    bool all = false;
+    bool almost_all = false;
+    bool long_format = false;
+    dir_sort sort = dir_sort::name;
+    bool reverse = false;
+    bool directories_first = false;
+    bool long_iso = false;
+    std::vector<std::string> paths;
+} dir_options_t;
+
+class dir_lister {
+public:
+    using sink_t = std::function<bool (const char*, size_t)>;
+
+    static bool parse(const std::string& command, dir_options_t& options);
+private:
+    struct entry {
+        std::string name;
+        unsigned char type;
+        mode_t mode;
+        nlink_t nlink;
+        uid_t uid;
+        gid_t gid;
+        off_t size;
+        blkcnt_t blocks;
+        time_t mtime;
+        long mtime_nsec;
+        bool link_dir;
+        std::string link;
+    };
+
+    using entry_list = std::vector<const entry*>;
+
+    struct node {
+        std::string path;
+        std::string block;
+        bool dispatched = false;
+        bool listed = false;
+        std::vector<std::shared_ptr<node>> children;
+    };
+
+    struct work_queue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<node>> nodes;
+    };
+
+    dir_options_t options;
+    unsigned int threads;
+    sink_t sink;
+    time_t now;
+
+    std::vector<std::unique_ptr<work_queue>> queues;
+    std::atomic<bool> finished;
+    std::atomic<bool> aborted;
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+
+    std::mutex emit_mutex;
+    std::condition_variable emit_cv;
+    std::string batch;
+    bool first_block;
+
+    std::mutex name_mutex;
+    std::map<uid_t, std::string> users;
+    std::map<gid_t, std::string> groups;
+
+    void push(unsigned int worker, std::shared_ptr<node> n);
+    std::shared_ptr<node> take(unsigned int worker);
+    void work(unsigned int worker);
+    void list_node(const std::shared_ptr<node>& n);
+    bool read_entries(const std::string& path, std::vector<entry>& entries);
+    bool needs_stat() const;
+    int compare(const entry* a, const entry* b) const;
+    bool before(const entry* a, const entry* b) const;
+    void sort_entries(entry_list& entries);
+    // `measured` sets the column widths when other entries share them
+    void format_entries(const entry_list& entries, bool with_total, std::string& out,
+                        const entry_list* measured = nullptr);
+    const std::string& user_name(uid_t uid);
+    const std::string& group_name(gid_t gid);
+    void emit_block(const std::string& block);
+    bool flush();
+public:
+    dir_lister(const dir_options_t& options, unsigned int threads = DIR_LISTER_THREADS);
+
+    bool run(sink_t output);
+};
+
+#endif
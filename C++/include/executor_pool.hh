@@ -0,0 +1,53 @@
+#ifndef __EXECUTOR_POOL_HH__
+#define __EXECUTOR_POOL_HH__
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <stdio.h>
+#include <limits.h>
+#include <sys/types.h>
+
+#include "definations.hh"
+
+class executor_pool {
+public:
+    // program is the resolved executable, or empty to go through the shell
+    using runner_t = std::function<void (const std::string& command, const std::string& program)>;
+    // called with the executor's pid just before it is handed the command
+    using dispatch_t = std::function<void (pid_t executor)>;
+private:
+    struct executor {
+        pid_t pid;
+        int fd;
+    };
+
+    runner_t runner;
+    unsigned int min_size;
+    unsigned int max_size;
+    unsigned int target;
+    unsigned int requested;
+    pid_t spawner_pid;
+    int control_fd;
+    std::deque<executor> idle;
+    std::mutex mutex;
+
+    void spawner_main(int fd);
+    void executor_main(int fd);
+    void replenish();
+    bool collect(bool wait);
+public:
+    executor_pool(runner_t runner, unsigned int min_size = EXECUTOR_POOL_MIN, unsigned int max_size = EXECUTOR_POOL_MAX);
+    executor_pool(const executor_pool& other) = delete;
+    ~executor_pool();
+
+    bool start();
+    // keep enough idle executors for this many concurrent run() callers
+    void resize(size_t concurrency);
+    FILE* run(const std::string& command, const std::string& program = std::string(),
+              const dispatch_t& on_dispatch = nullptr);
+    size_t available();
+};
+
+#endif
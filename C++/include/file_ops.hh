@@ -0,0 +1,54 @@
+#ifndef __FILE_OPS_HH__
+#define __FILE_OPS_HH__
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "definations.hh"
+
+enum class file_op_kind {
+    unlink,
+    rename
+};
+
+typedef struct _file_op {
+    file_op_kind kind;
+    std::string source;
+    std::string target;
+    int result;
+} file_op_t;
+
+typedef struct _file_ops_options {
+    bool move = false;
+    bool force = false;
+    bool verbose = false;
+    bool no_clobber = false;
+    std::vector<std::string> args;
+} file_ops_options_t;
+
+class file_ops {
+public:
+    using sink_t = std::function<bool (const char*, size_t)>;
+
+    static bool parse(const std::string& command, file_ops_options_t& options);
+private:
+    file_ops_options_t options;
+    unsigned int batch_size;
+    unsigned int threads;
+    bool use_uring;
+    std::vector<file_op_t> ops;
+
+    bool plan(std::string& report);
+    bool run_uring();
+    void run_threads();
+    bool fallback_move(const file_op_t& op, std::string& report);
+public:
+    file_ops(const file_ops_options_t& options, unsigned int batch_size = FILE_OPS_BATCH_SIZE,
+             unsigned int threads = FILE_OPS_THREADS, bool use_uring = true);
+
+    bool run(sink_t sink);
+    size_t count() const { return ops.size(); }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef __HEAVY_SLOTS_HH__
+#define __HEAVY_SLOTS_HH__
+
+#include <vector>
+#include <sys/types.h>
+
+#include "definations.hh"
+
+// Slots for heavy commands shared by every backend on the host, one SysV
+// semaphore per slot. A slot is held while its semaphore is 1; SEM_UNDO
+// frees it if the holder dies. New semaphores start at 0 on Linux, so the
+// set needs no initialization.
+class heavy_slots {
+private:
+    int sem_id;
+    unsigned int count;
+    std::vector<unsigned short> held;
+public:
+    heavy_slots(key_t key, unsigned int count = SCHEDULER_MAX_HEAVY);
+    heavy_slots(const heavy_slots& other) = delete;
+
+    // takes a free slot without waiting
+    bool try_acquire();
+    // frees the slot taken last
+    void release();
+    size_t holding() const { return held.size(); }
+
+    void destroy();
+};
+
+#endif
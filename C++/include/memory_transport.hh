@@ -0,0 +1,49 @@
+#ifndef __MEMORY_TRANSPORT_HH__
+#define __MEMORY_TRANSPORT_HH__
+
+#include <atomic>
+#include <functional>
+
+#include "definations.hh"
+#include "transport.hh"
+#include "message_queue.hh"
+#include "mpmc_queue.hh"
+
+// In-process transport for running the backend as a thread. Every message
+// type gets its own lock-free ring; receivers spin briefly, then sleep on
+// the channel futex, or on the shared control futex for negative types.
+class memory_transport : public transport {
+private:
+    struct event {
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> seq{ 0 };
+        std::atomic<uint32_t> waiters{ 0 };
+        std::atomic<uint32_t> spin{ MEMORY_TRANSPORT_SPIN_MIN };
+    };
+
+    struct channel {
+        std::atomic<long> type{ 0 };
+        std::atomic<mpmc_queue<msg_data_t>*> queue{ nullptr };
+        event ev;
+    };
+
+    channel channels[MEMORY_TRANSPORT_CHANNELS];
+    event control;
+
+    channel* find(long type, bool create);
+    event& event_for(long type);
+    bool try_receive(long type, msg_data_t& msg);
+    void wait(event& ev, const std::function<bool ()>& ready);
+    void notify(event& ev, int count);
+public:
+    memory_transport() = default;
+    memory_transport(const memory_transport& other) = delete;
+    ~memory_transport();
+
+    void send(long msg_type, std::string msg_data, long session = 0, long sent = 0) override;
+    std::tuple<long, std::string> receive(long type = 0) override;
+    std::tuple<long, long, std::string, long> receive_session(long type = 0, bool wait = true) override;
+
+    void destroy() override;
+};
+
+#endif
@@ -4,32 +4,73 @@
 #include <string>
 #include <sys/types.h>
 #include <tuple>
+#include <chrono>
 
 #include "definations.hh"
 #include "buffer.hh"
+#include "transport.hh"
+
+// steady clock nanoseconds; CLOCK_MONOTONIC is shared by every process, so
+// the receiver can tell how long a message has been waiting
+inline long message_clock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 typedef struct _message_data {
     long type;
+    long session;
+    long sent;
     char data[MESSAGE_DATA_SIZE];
 
     _message_data();
-    _message_data(long msg_type, std::string msg_data);
+    _message_data(long msg_type, std::string msg_data, long msg_session = 0);
     _message_data(const _message_data& other);
+    _message_data& operator=(const _message_data& other) = default;
 } msg_data_t;
 
 using msg_buf_t = buffer<msg_data_t>;
 
-class message_queue {
+inline long session_request_type(long session) {
+    return MESSAGE_TYPE_REQUEST_BASE + session;
+}
+
+inline bool is_request_type(long type) {
+    return type >= MESSAGE_TYPE_REQUEST_BASE && type <= -MESSAGE_TYPE_BACKEND_ACCEPTABLE;
+}
+
+inline long session_response_type(long session) {
+    return MESSAGE_TYPE_SESSION_BASE + session;
+}
+
+// replay session `index` of process `pid`; never equal to a frontend pid
+inline long replay_session(pid_t pid, unsigned int index) {
+    return MESSAGE_PID_MAX + (((long)pid << 8) | index);
+}
+
+// the process a session belongs to
+inline pid_t session_owner(long session) {
+    return session > MESSAGE_PID_MAX ? (pid_t)((session - MESSAGE_PID_MAX) >> 8) : (pid_t)session;
+}
+
+class message_queue : public transport {
 private:
     key_t msg_key;
     int msg_id;
+    bool owner;
 public:
+    static bool remove_stale(key_t key);
+
     message_queue(key_t key);
 
-    void send(long msg_type, std::string msg_data);
-    std::tuple<long, std::string> receive(long type = 0);
+    // true if this instance created the queue rather than joining one
+    bool created() const { return owner; }
+
+    void send(long msg_type, std::string msg_data, long session = 0, long sent = 0) override;
+    std::tuple<long, std::string> receive(long type = 0) override;
+    std::tuple<long, long, std::string, long> receive_session(long type = 0, bool wait = true) override;
 
-    void destroy();
+    void destroy() override;
 };
 
 #endif
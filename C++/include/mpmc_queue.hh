@@ -0,0 +1,88 @@
+#ifndef __MPMC_QUEUE_HH__
+#define __MPMC_QUEUE_HH__
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "definations.hh"
+
+// Bounded multi-producer/multi-consumer ring (D. Vyukov). Each slot carries
+// a sequence number telling producers and consumers whose turn it is.
+template <class _data_type>
+class mpmc_queue {
+private:
+    struct alignas(CACHE_LINE_SIZE) slot {
+        std::atomic<size_t> seq;
+        _data_type value;
+    };
+
+    std::unique_ptr<slot[]> slots;
+    size_t mask;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+public:
+    mpmc_queue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.reset(new slot[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+        tail.store(0, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    mpmc_queue(const mpmc_queue<_data_type>& other) = delete;
+
+    bool try_push(const _data_type& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        slot* s;
+        while (true) {
+            s = &slots[pos & mask];
+            size_t seq = s->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        s->value = value;
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(_data_type& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        slot* s;
+        while (true) {
+            s = &slots[pos & mask];
+            size_t seq = s->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        value = s->value;
+        s->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+#endif
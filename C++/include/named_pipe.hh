@@ -3,7 +3,12 @@
 
 #include "definations.hh"
 #include "buffer.hh"
+#include "codec.hh"
 #include <stdio.h>
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <functional>
 
 typedef struct _pipe_buffer_data {
     char data[PIPE_BUFFER_SIZE];
@@ -14,17 +19,49 @@ using pip_buf_t = buffer<pip_buf_data_t>;
 class named_pipe {
 public:
     static void make_pipe(const char* pipe_path);
+    static std::string session_path(long session);
+    static std::unique_ptr<named_pipe> open_writer(const char* pipe_path);
+    static size_t remove_stale();
+    // session pipes whose owner is alive and is not `except`
+    static size_t live_sessions(pid_t except);
 private:
+    static void for_each_session(const std::function<void (const std::string&, long)>& visit);
+
     int pipe_fd;
     int open_mode;
+    int peer_fd;
+    bool broken;
+    codec_type codec;
+    std::unique_ptr<compressor> comp;
+    std::unique_ptr<decompressor> decomp;
+    std::vector<char> frame;
+    std::string trailer_text;
+
+    named_pipe(int fd, int mode);
+    bool write_all(const char* data, size_t size);
+    bool read_all(char* data, size_t size);
 public:
     named_pipe(const char* pipe_path, int mode);
     named_pipe(const named_pipe& other) = delete;
     named_pipe(named_pipe&& other) = delete;
     ~named_pipe();
 
-    void pipe_from(FILE *fp);
-    void pipe_to(FILE *fp);
+    void set_codec(codec_type type);
+    void set_peer(int fd) { peer_fd = fd; }
+    bool is_broken() const { return broken; }
+    void reset();
+    codec_type get_codec() const { return codec; }
+    const compressor* get_compressor() const { return comp.get(); }
+
+    bool write_data(const char* data, size_t size);
+    // sent after the output and read back with trailer(), of any length
+    bool write_trailer(const std::string& text);
+    bool finish();
+    bool pipe_from(FILE *fp);
+    bool pipe_from(FILE *fp, const std::function<bool (const char*, size_t)>& stage);
+    size_t pipe_to(FILE *fp);
+    // the trailer of the command last read by pipe_to(), if any
+    const std::string& trailer() const { return trailer_text; }
 };
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef __PATH_CACHE_HH__
+#define __PATH_CACHE_HH__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "definations.hh"
+
+// Resolves command names against $PATH once and keeps the result until an
+// inotify event on one of the PATH directories touches that name. A
+// directory that cannot be watched (missing, removed, moved) is retried on
+// every miss, and results it could change are not cached meanwhile. Also
+// holds the environment block handed to every exec.
+class path_cache {
+public:
+    // splits a command without shell syntax into words
+    static bool plain_words(const std::string& command, std::vector<std::string>& args);
+    // plain words naming a program rather than a shell keyword or builtin
+    static bool simple_command(const std::string& command, std::vector<std::string>& args);
+private:
+    std::vector<std::string> dirs;
+    // inotify watch per directory, -1 while unwatched
+    std::vector<int> watches;
+    std::unordered_map<std::string, std::string> entries;
+    int inotify_fd;
+    std::vector<std::string> env_storage;
+    std::vector<char*> env;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long probes;
+    unsigned long invalidations;
+
+    void watch();
+    void drain();
+public:
+    path_cache(const char* path);
+    path_cache(const path_cache& other) = delete;
+    ~path_cache();
+
+    std::string resolve(const std::string& name);
+    char* const* envp() const { return const_cast<char* const*>(env.data()); }
+
+    unsigned long total_hits() const { return hits; }
+    unsigned long total_misses() const { return misses; }
+    unsigned long total_probes() const { return probes; }
+    unsigned long total_invalidations() const { return invalidations; }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __PATH_TRANSLATOR_HH__
+#define __PATH_TRANSLATOR_HH__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include "definations.hh"
+
+// Turns cmd-style paths (backslashes, drive letters, any letter case) into
+// the real Linux path. Directory contents are cached per session, keyed by
+// case-folded name, and kept current with inotify.
+class path_translator {
+private:
+    struct directory_t {
+        int wd;
+        std::unordered_map<std::string, std::vector<std::string>> entries;
+    };
+
+    std::string cwd;
+    std::unordered_map<std::string, directory_t> dirs;
+    std::unordered_multimap<int, std::string> watches;
+    directory_t scratch;
+    int inotify_fd;
+    unsigned long hits;
+    unsigned long loads;
+    unsigned long invalidations;
+
+    static std::string fold(std::string_view name);
+    void drain();
+    void drop(const std::string& dir);
+    void drop_all();
+    directory_t* load(const std::string& dir);
+    std::string lookup(const std::string& dir, const std::string& name);
+public:
+    path_translator(const std::string& cwd);
+    path_translator(const path_translator& other) = delete;
+    ~path_translator();
+
+    std::string translate(std::string_view path);
+
+    unsigned long total_hits() const { return hits; }
+    unsigned long total_loads() const { return loads; }
+    unsigned long total_invalidations() const { return invalidations; }
+};
+
+#endif
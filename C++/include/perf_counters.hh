@@ -0,0 +1,32 @@
+#ifndef __PERF_COUNTERS_HH__
+#define __PERF_COUNTERS_HH__
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// perf_event_open counters for one request: the calling thread with the
+// threads it starts, and separately any attached process and its children.
+// Events the machine or perf_event_paranoid does not allow are left out of
+// the report.
+class perf_counters {
+private:
+    struct counter_t {
+        size_t event;
+        int fd;
+        bool attached;
+    };
+    std::vector<counter_t> counters;
+
+    void open_all(pid_t pid);
+    std::string report(bool attached) const;
+public:
+    perf_counters();
+    perf_counters(const perf_counters& other) = delete;
+    ~perf_counters();
+
+    void attach(pid_t pid);
+    std::string report() const;
+};
+
+#endif
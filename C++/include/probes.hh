@@ -0,0 +1,15 @@
+#ifndef __PROBES_HH__
+#define __PROBES_HH__
+
+// Static tracepoints under the provider "libds", e.g.
+//   bpftrace -e 'usdt:./backend:libds:execute_done { ... }'
+// With <sys/sdt.h> each probe is a single nop plus an ELF note; without it,
+// or with DS_NO_PROBES, the arguments are not even evaluated.
+#if !defined(DS_NO_PROBES) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define DS_PROBE(name, ...) STAP_PROBEV(libds, name, ##__VA_ARGS__)
+#else
+#define DS_PROBE(name, ...) do { } while (0)
+#endif
+
+#endif
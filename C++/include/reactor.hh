@@ -0,0 +1,82 @@
+#ifndef __REACTOR_HH__
+#define __REACTOR_HH__
+
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <string>
+#include <coroutine>
+
+#include "definations.hh"
+#include "task.hh"
+
+// epoll event loop resuming coroutines when their descriptors become
+// readable. run() may be called from several threads at once.
+class reactor {
+private:
+    struct detached {
+        struct promise_type {
+            detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() { }
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    int epoll_fd;
+    int wake_fd;
+    std::atomic<size_t> pending;
+    std::mutex mutex;
+    std::deque<std::coroutine_handle<>> ready;
+
+    static detached launch(reactor* r, task<void> t);
+    bool resume_ready();
+    void poll(int timeout_ms);
+    void wake();
+public:
+    struct fd_awaiter {
+        reactor* r;
+        int fd;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { r->watch(fd, handle); }
+        void await_resume() const noexcept { }
+    };
+
+    struct schedule_awaiter {
+        reactor* r;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { r->post(handle); }
+        void await_resume() const noexcept { }
+    };
+
+    reactor();
+    reactor(const reactor& other) = delete;
+    ~reactor();
+
+    void spawn(task<void> t);
+    void post(std::coroutine_handle<> handle);
+    void watch(int fd, std::coroutine_handle<> handle);
+    void run();
+
+    fd_awaiter readable(int fd) { return fd_awaiter{ this, fd }; }
+    schedule_awaiter schedule() { return schedule_awaiter{ this }; }
+};
+
+// Non-blocking read side of a pipe, owned by the stream.
+class byte_stream {
+private:
+    reactor& r;
+    int fd;
+public:
+    byte_stream(reactor& r, int fd);
+    byte_stream(const byte_stream& other) = delete;
+    ~byte_stream();
+
+    task<size_t> read(char* data, size_t size);
+    task<std::string> read_some();
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __SCHEDULER_HH__
+#define __SCHEDULER_HH__
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ostream>
+
+#include "definations.hh"
+#include "heavy_slots.hh"
+
+using sched_clock = std::chrono::steady_clock;
+
+enum class priority_class {
+    interactive = 0,
+    batch = 1
+};
+
+typedef struct _sched_request {
+    long session;
+    std::string command;
+    priority_class priority;
+    bool heavy;
+    // when the frontend sent it, so time spent in the transport counts as waiting
+    sched_clock::time_point enqueued;
+} sched_request_t;
+
+typedef struct _sched_stats {
+    static constexpr const unsigned int HISTOGRAM_BUCKETS = 32;
+
+    unsigned long dispatched;
+    unsigned long long total_wait_us;
+    unsigned long long max_wait_us;
+    unsigned long histogram[HISTOGRAM_BUCKETS];
+
+    _sched_stats();
+    void record(unsigned long long wait_us);
+    unsigned long long percentile(double p) const;
+} sched_stats_t;
+
+class scheduler {
+public:
+    static priority_class classify(const std::string& command, bool& heavy);
+private:
+    struct session_queue {
+        std::deque<sched_request_t> pending;
+        unsigned int deficit = 0;
+    };
+
+    struct class_queue {
+        std::map<long, session_queue> sessions;
+        std::deque<long> active;
+        size_t depth = 0;
+        sched_stats_t stats;
+    };
+
+    class_queue classes[2];
+    unsigned int quantum;
+    unsigned int max_heavy;
+    unsigned int running_heavy;
+    heavy_slots* shared;
+
+    bool take_heavy_slot();
+    void release_heavy_slot();
+    bool runnable(const class_queue& cq, bool heavy_slot) const;
+    bool oldest_waited(const class_queue& cq, sched_clock::time_point now, unsigned int limit_ms) const;
+    bool dispatch(class_queue& cq, sched_request_t& req);
+public:
+    // `shared` also caps heavy commands together with other schedulers
+    scheduler(unsigned int quantum = SCHEDULER_QUANTUM, unsigned int max_heavy = SCHEDULER_MAX_HEAVY,
+              heavy_slots* shared = nullptr);
+
+    void push(long session, std::string command, sched_clock::time_point sent = sched_clock::now());
+    bool next(sched_request_t& req);
+    void finish(const sched_request_t& req);
+    // removes every queued request, in order within each session
+    std::vector<sched_request_t> drain();
+
+    bool empty() const;
+    size_t depth(priority_class priority) const;
+    const sched_stats_t& stats(priority_class priority) const;
+    void report(std::ostream& os) const;
+};
+
+#endif
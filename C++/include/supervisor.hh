@@ -0,0 +1,41 @@
+#ifndef __SUPERVISOR_HH__
+#define __SUPERVISOR_HH__
+
+#include <atomic>
+#include <thread>
+#include <sys/types.h>
+
+#include "definations.hh"
+#include "transport.hh"
+
+// Runs the backend process for one frontend session and restarts it with
+// bounded backoff. When the backend dies unexpectedly, the session's
+// pending response receive is woken with SUPERVISOR_LOST_MESSAGE. stop()
+// signals this session's backend and waits until it has exited.
+class supervisor {
+private:
+    transport& msq;
+    long session;
+    bool verbose;
+    pid_t pid;
+    int pid_fd;
+    unsigned int failures;
+    std::atomic<bool> stopping;
+    std::thread watcher;
+
+    bool spawn();
+    void reap();
+    void watch();
+public:
+    supervisor(transport& msq, long session, bool verbose);
+    supervisor(const supervisor& other) = delete;
+    ~supervisor();
+
+    bool start();
+    bool restart();
+    void succeeded() { failures = 0; }
+    void stop();
+    int liveness_fd() const { return pid_fd; }
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef __TASK_HH__
+#define __TASK_HH__
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// Lazily started coroutine. Awaiting a task starts it and resumes the
+// awaiting coroutine when it finishes.
+template <class _result_type>
+class task;
+
+class task_promise_base {
+private:
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+public:
+    struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <class _promise_type>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<_promise_type> handle) noexcept {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept { }
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    final_awaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+
+    void set_continuation(std::coroutine_handle<> handle) { continuation = handle; }
+    void rethrow() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+template <class _result_type>
+class task_promise : public task_promise_base {
+private:
+    std::optional<_result_type> value;
+public:
+    task<_result_type> get_return_object();
+    void return_value(_result_type result) { value = std::move(result); }
+
+    _result_type result() {
+        rethrow();
+        return std::move(*value);
+    }
+};
+
+template <>
+class task_promise<void> : public task_promise_base {
+public:
+    task<void> get_return_object();
+    void return_void() { }
+
+    void result() { rethrow(); }
+};
+
+template <class _result_type = void>
+class task {
+public:
+    using promise_type = task_promise<_result_type>;
+private:
+    std::coroutine_handle<promise_type> handle;
+public:
+    explicit task(std::coroutine_handle<promise_type> handle) : handle(handle) { }
+    task(const task& other) = delete;
+    task(task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) { }
+
+    ~task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().set_continuation(awaiting);
+        return handle;
+    }
+
+    _result_type await_resume() { return handle.promise().result(); }
+};
+
+template <class _result_type>
+task<_result_type> task_promise<_result_type>::get_return_object() {
+    return task<_result_type>(std::coroutine_handle<task_promise<_result_type>>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() {
+    return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+#endif
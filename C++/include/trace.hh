@@ -0,0 +1,46 @@
+#ifndef __TRACE_HH__
+#define __TRACE_HH__
+
+#include <string>
+#include <cstdint>
+#include <stdio.h>
+
+constexpr const char TRACE_MAGIC[] = "LCCTRACE";
+constexpr const uint8_t TRACE_VERSION = 1;
+
+typedef struct _trace_record {
+    uint64_t offset_us;
+    uint64_t latency_us;
+    uint64_t output_size;
+    std::string command;
+} trace_record_t;
+
+class trace_writer {
+private:
+    FILE* fp;
+    uint64_t last_offset;
+
+    void put_varint(uint64_t value);
+public:
+    trace_writer(const char* path);
+    trace_writer(const trace_writer& other) = delete;
+    ~trace_writer();
+
+    void write(const trace_record_t& record);
+};
+
+class trace_reader {
+private:
+    FILE* fp;
+    uint64_t last_offset;
+
+    bool get_varint(uint64_t& value);
+public:
+    trace_reader(const char* path);
+    trace_reader(const trace_reader& other) = delete;
+    ~trace_reader();
+
+    bool read(trace_record_t& record);
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef __TRANSPORT_HH__
+#define __TRANSPORT_HH__
+
+#include <string>
+#include <tuple>
+
+// Request/response channel between frontend and backend. Types follow
+// msgrcv(2): a positive type matches exactly, a negative type takes the
+// lowest type up to its absolute value. receive_session also returns the
+// session and the message_clock() time the message was sent; send takes
+// that time to pass a message on (0 stamps it now). A waiting
+// receive_session interrupted by a signal returns type 0.
+class transport {
+public:
+    virtual ~transport() = default;
+
+    virtual void send(long msg_type, std::string msg_data, long session = 0, long sent = 0) = 0;
+    virtual std::tuple<long, std::string> receive(long type = 0) = 0;
+    virtual std::tuple<long, long, std::string, long> receive_session(long type = 0, bool wait = true) = 0;
+
+    virtual void destroy() = 0;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef __URING_HH__
+#define __URING_HH__
+
+#include <linux/io_uring.h>
+#include <stddef.h>
+
+class uring {
+private:
+    int ring_fd;
+    void* sq_ring;
+    void* cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    io_uring_cqe* cqes;
+
+    unsigned int entries;
+    unsigned int cq_entries;
+    unsigned int pending;
+public:
+    uring(unsigned int entries);
+    uring(const uring& other) = delete;
+    ~uring();
+
+    bool valid() const { return ring_fd != -1; }
+    unsigned int capacity() const { return entries; }
+    // completions the ring holds before they overflow
+    unsigned int completion_capacity() const { return cq_entries; }
+    bool supports(unsigned char opcode);
+
+    io_uring_sqe* get_sqe();
+    int submit(unsigned int wait_nr);
+    // takes back the queued entries the kernel has not consumed; returns how many
+    unsigned int cancel_unsubmitted();
+    bool peek(io_uring_cqe& cqe);
+};
+
+#endif
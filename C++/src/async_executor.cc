@@ -0,0 +1,89 @@
+#include "async_executor.hh"
+
+#include <cerrno>
+#include <signal.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+extern char **environ;
+
+async_process::async_process(reactor& r, pid_t pid, int out_fd)
+    : r(r), pid(pid), out(r, out_fd) {
+    pid_fd = syscall(SYS_pidfd_open, pid, 0);
+}
+
+// Reaps a killed child once its pidfd says it is gone, off the caller's stack.
+static task<void> reap(reactor& r, pid_t pid, int pid_fd) {
+    co_await r.readable(pid_fd);
+    while (waitpid(pid, nullptr, 0) == -1 && errno == EINTR) { }
+    close(pid_fd);
+}
+
+async_process::~async_process() {
+    if (pid != -1) {
+        // abandoned before wait(): nobody reads the rest, so do not let it run on
+        kill(pid, SIGKILL);
+        if (waitpid(pid, nullptr, WNOHANG) == 0) {
+            if (pid_fd != -1) {
+                r.spawn(reap(r, pid, pid_fd));
+                return;
+            }
+            // no pidfd to wait on; a killed child exits promptly
+            while (waitpid(pid, nullptr, 0) == -1 && errno == EINTR) { }
+        }
+    }
+    if (pid_fd != -1) {
+        close(pid_fd);
+    }
+}
+
+task<int> async_process::wait() {
+    if (pid_fd != -1) {
+        co_await r.readable(pid_fd);
+    }
+    int status;
+    pid_t res;
+    while ((res = waitpid(pid, &status, 0)) == -1 && errno == EINTR) { }
+    pid = -1;
+    co_return res == -1 ? -1 : status;
+}
+
+async_executor::async_executor(reactor& r) : r(r) { }
+
+std::unique_ptr<async_process> async_executor::spawn(const std::string& command) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        return nullptr;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    char *argv[] = { (char *)"sh", (char *)"-c", (char *)command.c_str(), nullptr };
+    pid_t pid;
+    int res = posix_spawn(&pid, EXECUTOR_SHELL, &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (res != 0) {
+        close(fds[0]);
+        return nullptr;
+    }
+    return std::make_unique<async_process>(r, pid, fds[0]);
+}
+
+task<command_result_t> async_executor::run(std::string command) {
+    command_result_t result;
+    auto process = spawn(command);
+    if (!process) {
+        co_return result;
+    }
+    char buf[PIPE_BUFFER_SIZE];
+    size_t size;
+    while ((size = co_await process->output().read(buf, sizeof(buf))) > 0) {
+        result.output.append(buf, size);
+    }
+    result.status = co_await process->wait();
+    co_return result;
+}
@@ -1,69 +1,335 @@
+#include "backend.hh"
 #include "definations.hh"
 #include "message_queue.hh"
 #include "named_pipe.hh"
+#include "scheduler.hh"
+#include "heavy_slots.hh"
+#include "dir_lister.hh"
+#include "file_ops.hh"
+#include "executor_pool.hh"
+#include "dir_formatter.hh"
+#include "path_cache.hh"
+#include "perf_counters.hh"
+#include "probes.hh"
 
 #include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
 #include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
+#include <signal.h>
 #include <tuple>
+#include <map>
+#include <memory>
+#include <thread>
+#include <sstream>
+#include <vector>
 
-void backend(bool verbose = false);
+bool execute(executor_pool& pool, path_cache& paths, const std::string& command, named_pipe& np,
+             output_format format, perf_counters* counters, bool verbose);
+bool run_command(executor_pool& pool, path_cache& paths, const std::string& command, named_pipe& np,
+                 const dir_formatter::sink_t& sink, perf_counters* counters, bool verbose);
 
-int main(int argc, char *argv[]) {
-    int ch;
-    bool verbose = false;
-    while ((ch = getopt(argc, argv, "v")) != -1) {
-        switch (ch) {
-        case 'v':
-            verbose = true;
-            break;
-        default:
-            std::cout << "Unknown argument: " << ch << std::endl;
-            exit(EXIT_FAILURE);
+// Runs pwd and cd inside the executor instead of starting a shell. Each
+// executor serves one command, so cd changes nothing later commands see;
+// it only reports a directory it cannot enter, as sh would.
+static bool run_builtin(const std::vector<std::string>& args) {
+    if (args[0] == "pwd" && args.size() == 1) {
+        char cwd[PATH_MAX];
+        if (getcwd(cwd, sizeof(cwd))) {
+            printf("%s\n", cwd);
         }
+        else {
+            perror("pwd");
+        }
+        return true;
+    }
+    if (args[0] == "cd" && args.size() <= 2 && (args.size() == 1 || args[1] != "-")) {
+        const char* dir = args.size() == 2 ? args[1].c_str() : getenv("HOME");
+        if (dir && chdir(dir) == -1) {
+            fprintf(stderr, "cd: %s: %s\n", dir, strerror(errno));
+        }
+        return true;
     }
-    backend(verbose);
-    return 0;
+    return false;
 }
 
-void backend(bool verbose) {
+void backend(transport& msq, bool verbose, const volatile sig_atomic_t* stop) {
     if (verbose) {
         std::cout << "[BE] Preparing IPC..." << std::endl;
     }
-    named_pipe np(NAMED_PIPE_PATH, O_WRONLY);
-    message_queue msq(MESSAGE_QUEUE_KEY);
+    signal(SIGPIPE, SIG_IGN);
+    // built before the pool starts so executors inherit the prepared envp
+    path_cache paths(getenv("PATH"));
+    executor_pool pool([&paths](const std::string& command, const std::string& program) {
+        std::vector<std::string> args;
+        if (path_cache::plain_words(command, args) && run_builtin(args)) {
+            return;
+        }
+        if (!program.empty() && path_cache::simple_command(command, args)) {
+            std::vector<char *> argv;
+            for (auto& arg : args) {
+                argv.push_back(arg.data());
+            }
+            argv.push_back(nullptr);
+            execve(program.c_str(), argv.data(), paths.envp());
+        }
+        execle(EXECUTOR_SHELL, "sh", "-c", command.c_str(), (char *)nullptr, paths.envp());
+        perror("execl");
+    });
+    if (!pool.start()) {
+        perror("executor_pool");
+    }
+    std::map<long, std::unique_ptr<named_pipe>> pipes;
+    std::map<long, codec_type> codecs;
+    std::map<long, output_format> formats;
+    std::map<long, bool> perf;
+    heavy_slots heavy(SCHEDULER_HEAVY_KEY);
+    scheduler sched(SCHEDULER_QUANTUM, SCHEDULER_MAX_HEAVY, &heavy);
     long msg_type;
+    long session;
     std::string msg_data;
+    long sent;
 
     if (verbose) {
         std::cout << "[BE] Ready. Starting main loop..." << std::endl;
     }
     msq.send(MESSAGE_TYPE_READY, "");
 
+    // other backends serve the same queue, so requests taken but not run
+    // go back to it with their original send time
+    auto shutdown = [&]() {
+        auto drained = sched.drain();
+        for (const auto& req : drained) {
+            msq.send(session_request_type(req.session), req.command, req.session,
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(req.enqueued.time_since_epoch()).count());
+        }
+        if (verbose) {
+            std::cout << "[BE] Exiting. Handed back " << drained.size() << " queued request(s)" << std::endl;
+            std::cout << "[BE] Scheduler statistics:" << std::endl;
+            sched.report(std::cout);
+            std::cout << "[BE] PATH cache: " << paths.total_hits() << " hits, " << paths.total_misses()
+                      << " misses, " << paths.total_probes() << " probes, "
+                      << paths.total_invalidations() << " invalidations" << std::endl;
+        }
+    };
+
     while (true) {
-        std::tie(msg_type, msg_data) = msq.receive(MESSAGE_TYPE_BACKEND_ACCEPTABLE);
-        if (msg_type == MESSAGE_TYPE_REQUEST) {
-            if (verbose) {
-                std::cout << "[BE] Receiving message. Request: '" << msg_data << "'" << std::endl;
+        if (stop && *stop) {
+            shutdown();
+            return;
+        }
+        bool wait = sched.empty();
+        bool exiting = false;
+        while (true) {
+            std::tie(msg_type, session, msg_data, sent) = msq.receive_session(MESSAGE_TYPE_BACKEND_ACCEPTABLE, wait);
+            wait = false;
+            if (is_request_type(msg_type)) {
+                if (verbose) {
+                    std::cout << "[BE] Receiving message. Session: " << session << " Request: '" << msg_data << "'" << std::endl;
+                }
+                DS_PROBE(request_queued, session, msg_data.c_str());
+                sched.push(session, msg_data, sched_clock::time_point(std::chrono::nanoseconds(sent)));
             }
-            FILE *ppipe = popen(msg_data.c_str(), "r");
-            if (!ppipe) {
-                perror("popen");
-                exit(EXIT_FAILURE);
-            } else {
-                np.pipe_from(ppipe);
-
+            else if (msg_type == MESSAGE_TYPE_SESSION) {
+                codec_type codec = codec_type::none;
+                output_format format = output_format::raw;
+                bool counters = false;
+                std::istringstream options(msg_data);
+                std::string option;
+                while (options >> option) {
+                    if (option.compare(0, 6, "codec=") == 0) {
+                        codec = codec_from_name(option.substr(6));
+                    }
+                    else if (option.compare(0, 7, "format=") == 0) {
+                        format = output_format_from_name(option.substr(7));
+                    }
+                    else if (option == "perf=on") {
+                        counters = true;
+                    }
+                }
+                codecs[session] = codec;
+                formats[session] = format;
+                perf[session] = counters;
+                auto it = pipes.find(session);
+                if (it != pipes.end()) {
+                    it->second->set_codec(codec);
+                }
                 if (verbose) {
-                    std::cout << "[BE] Command execution finished. Sending response..." << std::endl;
+                    std::cout << "[BE] Session " << session << " negotiated codec: " << codec_name(codec)
+                              << ", format: " << output_format_name(format)
+                              << (counters ? ", perf counters" : "") << std::endl;
                 }
-                msq.send(MESSAGE_TYPE_RESPONSE, "");
+                msq.send(session_response_type(session),
+                         std::string("codec=") + codec_name(codec) + " format=" + output_format_name(format)
+                         + (counters ? " perf=on" : ""), session);
+            }
+            else if (msg_type == MESSAGE_TYPE_EXIT) {
+                // only sent over the in-process transport, which has a single backend
+                exiting = true;
+                break;
+            }
+            else {
+                break;
+            }
+        }
+        if (exiting || (stop && *stop)) {
+            shutdown();
+            return;
+        }
+
+        sched_request_t req;
+        if (!sched.next(req)) {
+            if (!sched.empty()) {
+                // only heavy work is left and other backends hold every slot
+                std::this_thread::sleep_for(std::chrono::milliseconds(SCHEDULER_HEAVY_POLL_MS));
+            }
+            continue;
+        }
+        if (verbose) {
+            std::cout << "[BE] Dispatching request of session " << req.session
+                      << " (" << (req.priority == priority_class::batch ? "batch" : "interactive") << ")."
+                      << " Queued: " << sched.depth(priority_class::interactive) << " interactive, "
+                      << sched.depth(priority_class::batch) << " batch" << std::endl;
+        }
+
+        auto waited = std::chrono::duration_cast<std::chrono::microseconds>(sched_clock::now() - req.enqueued).count();
+        DS_PROBE(request_dispatch, req.session, waited);
+
+        auto it = pipes.find(req.session);
+        if (it == pipes.end()) {
+            auto np = named_pipe::open_writer(named_pipe::session_path(req.session).c_str());
+            if (np) {
+                auto codec = codecs.find(req.session);
+                if (codec != codecs.end()) {
+                    np->set_codec(codec->second);
+                }
+                it = pipes.emplace(req.session, std::move(np)).first;
+            }
+        }
+        if (it == pipes.end()) {
+            if (verbose) {
+                std::cout << "[BE] Session " << req.session << " has no reader. Dropping request..." << std::endl;
             }
+            sched.finish(req);
+            continue;
+        }
+
+        const compressor* comp = it->second->get_compressor();
+        unsigned long long in = comp ? comp->total_in() : 0;
+        unsigned long long out = comp ? comp->total_out() : 0;
+        auto format = formats.find(req.session);
+        std::unique_ptr<perf_counters> counters;
+        auto counted = perf.find(req.session);
+        if (counted != perf.end() && counted->second) {
+            counters.reset(new perf_counters());
         }
-        else if (msg_type == MESSAGE_TYPE_EXIT) {
+        DS_PROBE(execute_start, req.session, req.command.c_str());
+        bool connected = execute(pool, paths, req.command, *it->second,
+                                 format != formats.end() ? format->second : output_format::raw, counters.get(), verbose);
+        DS_PROBE(execute_done, req.session, connected);
+        // after the output on the pipe: the counters outgrow a message
+        std::string report;
+        if (counters) {
+            report = "sched-wait-us=" + std::to_string(waited) + " " + counters->report();
             if (verbose) {
-                std::cout << "[BE] Receiving message. Exiting..." << std::endl;
+                std::cout << "[BE] Counters: " << report << std::endl;
+            }
+        }
+        if (!connected || !it->second->write_trailer(report) || !it->second->finish()) {
+            pipes.erase(it);
+            comp = nullptr;
+        }
+        sched.finish(req);
+
+        if (verbose) {
+            if (comp) {
+                std::cout << "[BE] Output " << comp->total_in() - in << " bytes, sent "
+                          << comp->total_out() - out << " bytes" << std::endl;
             }
-            exit(EXIT_SUCCESS);
+            std::cout << "[BE] Command execution finished. Sending response..." << std::endl;
+        }
+        msq.send(session_response_type(req.session), "", req.session);
+    }
+}
+
+bool execute(executor_pool& pool, path_cache& paths, const std::string& command, named_pipe& np,
+             output_format format, perf_counters* counters, bool verbose) {
+    dir_formatter::sink_t sink = [&np](const char* data, size_t size) {
+        return np.write_data(data, size);
+    };
+    std::unique_ptr<dir_formatter> formatter;
+    dir_options_t format_options;
+    if (format == output_format::cmd && dir_formatter::detect(command, format_options)) {
+        if (verbose) {
+            std::cout << "[BE] Formatting listing as cmd output..." << std::endl;
+        }
+        formatter.reset(new dir_formatter(format_options, sink));
+        sink = [&formatter](const char* data, size_t size) {
+            return formatter->feed(data, size);
+        };
+    }
+
+    bool connected = run_command(pool, paths, command, np, sink, counters, verbose);
+    if (formatter && !formatter->finish()) {
+        connected = false;
+    }
+    return connected;
+}
+
+bool run_command(executor_pool& pool, path_cache& paths, const std::string& command, named_pipe& np,
+                 const dir_formatter::sink_t& sink, perf_counters* counters, bool verbose) {
+    dir_options_t dir_options;
+    if (dir_lister::parse(command, dir_options)) {
+        if (verbose) {
+            std::cout << "[BE] Listing natively..." << std::endl;
+        }
+        dir_lister lister(dir_options);
+        return lister.run(sink);
+    }
+
+    file_ops_options_t file_options;
+    if (file_ops::parse(command, file_options)) {
+        file_ops engine(file_options);
+        if (verbose) {
+            std::cout << "[BE] Running file operations natively..." << std::endl;
         }
+        return engine.run(sink);
+    }
+
+    std::string program;
+    std::vector<std::string> args;
+    if (path_cache::simple_command(command, args)) {
+        program = paths.resolve(args.front());
+        if (verbose && !program.empty()) {
+            std::cout << "[BE] Resolved '" << args.front() << "' to " << program << ", skipping the shell" << std::endl;
+        }
+    }
+
+    executor_pool::dispatch_t on_dispatch;
+    if (counters) {
+        on_dispatch = [counters](pid_t executor) {
+            counters->attach(executor);
+        };
+    }
+    FILE *epipe = pool.run(command, program, on_dispatch);
+    if (epipe) {
+        if (verbose) {
+            std::cout << "[BE] Handed off to executor. Idle executors: " << pool.available() << std::endl;
+        }
+        bool connected = np.pipe_from(epipe, sink);
+        fclose(epipe);
+        return connected;
+    }
+
+    FILE *ppipe = popen(command.c_str(), "r");
+    if (!ppipe) {
+        perror("popen");
+        exit(EXIT_FAILURE);
     }
+    bool connected = np.pipe_from(ppipe, sink);
+    pclose(ppipe);
+    return connected;
 }
@@ -0,0 +1,39 @@
+#include "backend.hh"
+#include "message_queue.hh"
+
+#include <iostream>
+#include <signal.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int) {
+    stop_requested = 1;
+}
+
+int main(int argc, char *argv[]) {
+    int ch;
+    bool verbose = false;
+    while ((ch = getopt(argc, argv, "v")) != -1) {
+        switch (ch) {
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            std::cout << "Unknown argument: " << ch << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    // the queue is shared by every session's backend, so each one is
+    // stopped by signal rather than by a message any of them could take;
+    // msgrcv(2) is never restarted, so a blocked receive wakes up
+    struct sigaction sa = {};
+    sa.sa_handler = request_stop;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    message_queue msq(MESSAGE_QUEUE_KEY);
+    backend(msq, verbose, &stop_requested);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "codec.hh"
+
+#include <cstring>
+
+codec_type codec_from_name(const std::string& name) {
+    if (name == "zlib") {
+        return codec_type::zlib;
+    }
+    return codec_type::none;
+}
+
+const char* codec_name(codec_type type) {
+    switch (type) {
+    case codec_type::zlib:
+        return "zlib";
+    default:
+        return "none";
+    }
+}
+
+compressor::compressor(codec_type type, int level)
+    : type(type), skip_frames(0), bytes_in(0), bytes_out(0) {
+    std::memset(&stream, 0, sizeof(stream));
+    if (type == codec_type::zlib) {
+        if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            this->type = codec_type::none;
+        }
+    }
+}
+
+compressor::~compressor() {
+    if (type == codec_type::zlib) {
+        deflateEnd(&stream);
+    }
+}
+
+codec_type compressor::compress(const char* data, size_t size, std::vector<char>& out) {
+    bytes_in += size;
+    if (type == codec_type::none || size < COMPRESSION_MIN_SIZE) {
+        bytes_out += size;
+        return codec_type::none;
+    }
+    if (skip_frames > 0) {
+        skip_frames--;
+        bytes_out += size;
+        return codec_type::none;
+    }
+
+    size_t limit = size - size * COMPRESSION_MIN_SAVING_PERCENT / 100;
+    out.resize(limit);
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = size;
+    stream.next_out = (Bytef *)out.data();
+    stream.avail_out = limit;
+    int res = deflate(&stream, Z_SYNC_FLUSH);
+    if (res != Z_OK || stream.avail_in > 0 || stream.avail_out == 0) {
+        // sent raw: forget this frame, the reader will not have it
+        deflateReset(&stream);
+        skip_frames = COMPRESSION_BACKOFF_FRAMES;
+        bytes_out += size;
+        return codec_type::none;
+    }
+    out.resize(limit - stream.avail_out);
+    bytes_out += out.size();
+    return type;
+}
+
+void compressor::reset() {
+    if (type == codec_type::zlib) {
+        deflateReset(&stream);
+    }
+    skip_frames = 0;
+}
+
+decompressor::decompressor(codec_type type)
+    : type(type) {
+    std::memset(&stream, 0, sizeof(stream));
+    if (type == codec_type::zlib) {
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            this->type = codec_type::none;
+        }
+    }
+}
+
+decompressor::~decompressor() {
+    if (type == codec_type::zlib) {
+        inflateEnd(&stream);
+    }
+}
+
+bool decompressor::decompress(const char* data, size_t size, size_t raw_size, std::vector<char>& out) {
+    if (type != codec_type::zlib) {
+        return false;
+    }
+    out.resize(raw_size);
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = size;
+    stream.next_out = (Bytef *)out.data();
+    stream.avail_out = raw_size;
+    int res = inflate(&stream, Z_SYNC_FLUSH);
+    return (res == Z_OK || res == Z_BUF_ERROR) && stream.avail_in == 0 && stream.avail_out == 0;
+}
+
+void decompressor::reset() {
+    if (type == codec_type::zlib) {
+        inflateReset(&stream);
+    }
+}
@@ -1,64 +1,183 @@
 #include "converter.hh"
 #include <iostream>
+#include <cctype>
 
-std::tuple<std::string, std::string> converter::get_command(std::string command) {
-    std::string::size_type pos;
-    pos = command.find(" ");
-    if (pos == command.size() - 1) {
-        return std::make_tuple(command.substr(0, pos), std::string());
-    } else if (pos > command.size() - 1) {
-        return std::make_tuple(command, std::string());
+std::tuple<std::string_view, std::string_view> converter::get_command(std::string_view command) {
+    std::string_view::size_type pos;
+    pos = command.find(' ');
+    if (pos == std::string_view::npos) {
+        return std::make_tuple(command, std::string_view());
     } else {
         return std::make_tuple(command.substr(0, pos), command.substr(pos + 1));
     }
 }
 
-converter::converter() {
+converter::converter(bool cmd_format, path_translator* paths)
+    : cmd_format(cmd_format), paths(paths) {
     initialize();
 }
 
+std::string converter::translate_args(std::string_view args) {
+    if (!paths) {
+        return std::string(args);
+    }
+    std::string res;
+    std::string_view::size_type pos = 0;
+    while (pos <= args.size()) {
+        std::string_view::size_type end = args.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = args.size();
+        }
+        if (pos > 0) {
+            res += ' ';
+        }
+        if (end > pos) {
+            res += paths->translate(args.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    return res;
+}
+
+// /o[:]<keys> with keys N, S, E, D, G, each optionally negated by '-'.
+// cmd sorts by every key in turn; ls only has one sort key, so the first
+// of N/S/E/D decides and G groups directories first. Plain /o means /oGN.
+static bool sort_flags(std::string_view flag, std::string& flags) {
+    std::string_view::size_type i = 2;
+    if (i < flag.size() && flag[i] == ':') {
+        i++;
+    }
+    if (i == flag.size()) {
+        flags = " --group-directories-first";
+        return true;
+    }
+    char primary = 0;
+    bool reverse = false;
+    bool group = false;
+    while (i < flag.size()) {
+        bool negated = flag[i] == '-';
+        if (negated) {
+            i++;
+        }
+        if (i == flag.size() || std::string_view("nsedg").find(flag[i]) == std::string_view::npos) {
+            return false;
+        }
+        char key = flag[i++];
+        if (key == 'g') {
+            group |= !negated;
+        } else if (!primary) {
+            primary = key;
+            reverse = negated;
+        }
+    }
+    // cmd sorts sizes and dates ascending, ls descending
+    switch (primary) {
+    case 'n': flags = reverse ? " -r" : ""; break;
+    case 's': flags = reverse ? " -S" : " -S -r"; break;
+    case 'e': flags = reverse ? " -X -r" : " -X"; break;
+    case 'd': flags = reverse ? " -t" : " -t -r"; break;
+    default: flags.clear(); break;
+    }
+    if (group) {
+        flags += " --group-directories-first";
+    }
+    return true;
+}
+
 void converter::initialize() {
-    command_map["dir"] = [](std::string command, std::string args) -> std::string {
+    command_map["dir"] = [this](std::string_view, std::string_view args) -> std::string {
         std::string res("ls");
-        if (args.size() > 0) {
-            res += " " + args;
+        bool bare = false;
+        std::string rest;
+        bool recursive = false;
+        bool sorted = false;
+        std::string sort;
+        std::string_view::size_type pos = 0;
+        while (pos < args.size()) {
+            std::string_view::size_type end = args.find(' ', pos);
+            if (end == std::string_view::npos) {
+                end = args.size();
+            }
+            std::string_view token = args.substr(pos, end - pos);
+            pos = end + 1;
+            if (token.empty()) {
+                continue;
+            }
+            if (token[0] != '/') {
+                rest += ' ';
+                if (paths) {
+                    rest += paths->translate(token);
+                } else {
+                    rest += token;
+                }
+                continue;
+            }
+
+            std::string lower(token);
+            for (auto& c : lower) {
+                c = std::tolower(static_cast<unsigned char>(c));
+            }
+            if (lower == "/s") {
+                recursive = true;
+            } else if (lower == "/a") {
+                res += " -a";
+            } else if (lower == "/b") {
+                res += " -1";
+                bare = true;
+            } else if (lower.compare(0, 2, "/o") == 0 && sort_flags(lower, sort)) {
+                sorted = true;
+            } else {
+                rest += ' ';
+                if (paths) {
+                    rest += paths->translate(token);
+                } else {
+                    rest += token;
+                }
+            }
+        }
+        // cmd lists /s results in directory order unless /o asks for sorting
+        if (recursive) {
+            res += sorted ? " -R" : " -RU";
         }
-        return res;
+        res += sort;
+        // the backend reformats long listings into cmd layout
+        if (cmd_format && !bare) {
+            res += " -l --time-style=long-iso";
+        }
+        return res + rest;
     };
-    command_map["rename"] = [](std::string command, std::string args) -> std::string {
-        return "mv " + args;
+    command_map["rename"] = [this](std::string_view, std::string_view args) -> std::string {
+        return "mv " + translate_args(args);
     };
-    command_map["move"] = [](std::string command, std::string args) -> std::string {
-        return "mv " + args;
+    command_map["move"] = [this](std::string_view, std::string_view args) -> std::string {
+        return "mv " + translate_args(args);
     };
-    command_map["del"] = [](std::string command, std::string args) -> std::string {
-        return "rm " + args;
+    command_map["del"] = [this](std::string_view, std::string_view args) -> std::string {
+        return "rm " + translate_args(args);
     };
-    command_map["cd"] = [](std::string command, std::string args) -> std::string {
-        bool is_empty_args = true;
-        if (args.size() > 0) {
-            for (auto c : args) {
-                if (c != ' ' && c != '\n' && c != '\0') {
-                    is_empty_args = false;
-                    break;
-                }
-            }
-        }
-        if (is_empty_args) {
+    command_map["cd"] = [this](std::string_view, std::string_view args) -> std::string {
+        if (args.find_first_not_of(std::string_view(" \n\0", 3)) == std::string_view::npos) {
             return std::string("pwd");
         } else {
-            return "cd " + args;
+            return "cd " + translate_args(args);
         }
     };
 }
 
-std::string converter::convert(std::string command) {
-    std::string cmd;
-    std::string args;
+std::string converter::convert(const std::string& command) {
+    std::string_view cmd;
+    std::string_view args;
     std::tie(cmd, args) = get_command(command);
-    if (command_map.count(cmd) > 0) {
-        return command_map[cmd](cmd, args);
+    auto it = command_map.find(cmd);
+    if (it != command_map.end()) {
+        return it->second(cmd, args);
     } else {
         return command;
     }
 }
+
+std::string convert(const std::string& command, bool cmd_format) {
+    thread_local converter plain;
+    thread_local converter cmd(true);
+    return (cmd_format ? cmd : plain).convert(command);
+}
@@ -0,0 +1,287 @@
+#include "dir_formatter.hh"
+
+#include <cstring>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/statvfs.h>
+
+output_format output_format_from_name(const std::string& name) {
+    if (name == "cmd") {
+        return output_format::cmd;
+    }
+    return output_format::raw;
+}
+
+const char* output_format_name(output_format format) {
+    switch (format) {
+    case output_format::cmd:
+        return "cmd";
+    default:
+        return "raw";
+    }
+}
+
+static const char* skip_token(const char* p, const char* end) {
+    while (p < end && *p != ' ') {
+        p++;
+    }
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    return p;
+}
+
+static const char* token_end(const char* p, const char* end) {
+    while (p < end && *p != ' ') {
+        p++;
+    }
+    return p;
+}
+
+static bool looks_like_entry(const char* begin, const char* end) {
+    if (end - begin < 11 || !std::strchr("-dlcbps", begin[0])) {
+        return false;
+    }
+    for (int i = 1; i < 10; i++) {
+        if (!std::strchr("rwxsStT-", begin[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool dir_formatter::detect(const std::string& command, dir_options_t& options) {
+    if (command.compare(0, 3, "ls ") != 0 || command.find_first_of("|;&<>`$") != std::string::npos) {
+        return false;
+    }
+    std::string::size_type pos = 3;
+    while (pos < command.size()) {
+        std::string::size_type end = command.find(' ', pos);
+        if (end == std::string::npos) {
+            end = command.size();
+        }
+        std::string token = command.substr(pos, end - pos);
+        pos = end + 1;
+        if (token == "--time-style=long-iso") {
+            options.long_iso = true;
+        } else if (token.size() > 1 && token[0] == '-' && token[1] != '-') {
+            options.long_format |= token.find('l') != std::string::npos;
+            options.recursive |= token.find('R') != std::string::npos;
+        } else if (!token.empty() && token[0] != '-') {
+            options.paths.push_back(token);
+        }
+    }
+    return options.long_format && options.long_iso;
+}
+
+dir_formatter::dir_formatter(const dir_options_t& options, sink_t sink)
+    : sink(sink), recursive(options.recursive), in_dir(false), block_start(true), listed_dirs(0), connected(true) {
+    char buf[PATH_MAX];
+    cwd = getcwd(buf, sizeof(buf)) ? buf : ".";
+    first_dir = options.paths.empty() ? "." : options.paths.front();
+    out.reserve(PIPE_BUFFER_SIZE * 2);
+}
+
+bool dir_formatter::feed(const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        const char* nl = (const char *)std::memchr(p, '\n', end - p);
+        if (!nl) {
+            line.append(p, end - p);
+            break;
+        }
+        if (line.empty()) {
+            process_line(p, nl);
+        } else {
+            line.append(p, nl - p);
+            process_line(line.data(), line.data() + line.size());
+            line.clear();
+        }
+        p = nl + 1;
+    }
+    return flush(false);
+}
+
+bool dir_formatter::finish() {
+    if (!line.empty()) {
+        process_line(line.data(), line.data() + line.size());
+        line.clear();
+    }
+    if (in_dir) {
+        close_dir();
+    }
+    if (listed_dirs > 0) {
+        if (recursive) {
+            out += "\n     Total Files Listed:\n";
+            append_summary(total_counts.files, "File(s)", total_counts.bytes, 14, " bytes\n");
+        }
+        struct statvfs vfs;
+        unsigned long long free_bytes = 0;
+        if (statvfs(first_dir.c_str(), &vfs) == 0) {
+            free_bytes = (unsigned long long)vfs.f_bavail * vfs.f_frsize;
+        }
+        append_summary(total_counts.dirs, "Dir(s)", free_bytes, 15, " bytes free\n");
+    }
+    return flush(true);
+}
+
+void dir_formatter::process_line(const char* begin, const char* end) {
+    if (begin == end) {
+        block_start = true;
+        return;
+    }
+    if (block_start && end[-1] == ':' && !looks_like_entry(begin, end)) {
+        if (in_dir) {
+            close_dir();
+        }
+        open_dir(begin, end - begin - 1);
+        block_start = false;
+        return;
+    }
+    block_start = false;
+    if (!in_dir) {
+        open_dir(first_dir.data(), first_dir.size());
+    }
+    if (end - begin >= 6 && std::memcmp(begin, "total ", 6) == 0) {
+        return;
+    }
+    if (!format_entry(begin, end)) {
+        out.append(begin, end - begin);
+        out += '\n';
+    }
+}
+
+void dir_formatter::open_dir(const char* path, size_t size) {
+    if (listed_dirs > 0) {
+        out += '\n';
+    }
+    out += " Directory of ";
+    if (size > 0 && path[0] == '/') {
+        out.append(path, size);
+    } else {
+        out += cwd;
+        if (size >= 2 && path[0] == '.' && path[1] == '/') {
+            path += 2;
+            size -= 2;
+        }
+        if (size > 0 && !(size == 1 && path[0] == '.')) {
+            if (cwd != "/") {
+                out += '/';
+            }
+            out.append(path, size);
+        }
+    }
+    out += "\n\n";
+    in_dir = true;
+    dir_counts = counts();
+    listed_dirs++;
+}
+
+void dir_formatter::close_dir() {
+    append_summary(dir_counts.files, "File(s)", dir_counts.bytes, 14, " bytes\n");
+    total_counts.files += dir_counts.files;
+    total_counts.bytes += dir_counts.bytes;
+    total_counts.dirs += dir_counts.dirs;
+    in_dir = false;
+}
+
+bool dir_formatter::format_entry(const char* begin, const char* end) {
+    if (!looks_like_entry(begin, end)) {
+        return false;
+    }
+    char type = begin[0];
+    const char* p = skip_token(begin, end);
+    p = skip_token(p, end);
+    p = skip_token(p, end);
+    p = skip_token(p, end);
+
+    const char* size_end = token_end(p, end);
+    unsigned long long size = 0;
+    for (const char* q = p; q < size_end && *q >= '0' && *q <= '9'; q++) {
+        size = size * 10 + (*q - '0');
+    }
+    bool device = size_end > p && size_end[-1] == ',';
+    p = skip_token(p, end);
+    if (device) {
+        p = skip_token(p, end);
+    }
+
+    const char* date = p;
+    const char* date_end = token_end(date, end);
+    const char* time = skip_token(date, end);
+    const char* time_end = token_end(time, end);
+    if (time_end >= end) {
+        return false;
+    }
+    const char* name = time_end + 1;
+
+    out.append(date, date_end - date);
+    out += "  ";
+    out.append(time, time_end - time);
+    out += "    ";
+    if (type == 'd') {
+        out += "<DIR>          ";
+        out.append(name, end - name);
+        dir_counts.dirs++;
+    } else if (type == 'l') {
+        out += "<SYMLINK>      ";
+        const char* arrow = (const char *)memmem(name, end - name, " -> ", 4);
+        if (arrow) {
+            out.append(name, arrow - name);
+            out += " [";
+            out.append(arrow + 4, end - arrow - 4);
+            out += ']';
+        } else {
+            out.append(name, end - name);
+        }
+        dir_counts.files++;
+    } else {
+        append_number(device ? 0 : size, 14);
+        out += ' ';
+        out.append(name, end - name);
+        dir_counts.files++;
+        dir_counts.bytes += device ? 0 : size;
+    }
+    out += '\n';
+    return true;
+}
+
+void dir_formatter::append_number(unsigned long long value, int width) {
+    char buf[32];
+    int n = 0;
+    int digits = 0;
+    do {
+        if (digits > 0 && digits % 3 == 0) {
+            buf[n++] = ',';
+        }
+        buf[n++] = '0' + value % 10;
+        value /= 10;
+        digits++;
+    } while (value > 0);
+    if (n < width) {
+        out.append(width - n, ' ');
+    }
+    while (n > 0) {
+        out += buf[--n];
+    }
+}
+
+void dir_formatter::append_summary(unsigned long long count, const char* label, unsigned long long bytes, int width, const char* suffix) {
+    append_number(count, 16);
+    out += ' ';
+    out += label;
+    out += ' ';
+    append_number(bytes, width);
+    out += suffix;
+}
+
+bool dir_formatter::flush(bool force) {
+    if (out.size() >= PIPE_BUFFER_SIZE || (force && !out.empty())) {
+        if (connected) {
+            connected = sink(out.data(), out.size());
+        }
+        out.clear();
+    }
+    return connected;
+}
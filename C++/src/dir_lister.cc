@@ -0,0 +1,544 @@
+#include "dir_lister.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <grp.h>
+#include <time.h>
+#include <sys/stat.h>
+
+bool dir_lister::parse(const std::string& command, dir_options_t& options) {
+    std::vector<std::string> tokens;
+    std::string::size_type pos = 0;
+    while (pos < command.size()) {
+        std::string::size_type end = command.find(' ', pos);
+        if (end == std::string::npos) {
+            end = command.size();
+        }
+        if (end > pos) {
+            tokens.push_back(command.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    if (tokens.empty() || tokens[0] != "ls") {
+        return false;
+    }
+
+    for (size_t i = 1; i < tokens.size(); i++) {
+        const std::string& token = tokens[i];
+        if (token == "--time-style=long-iso") {
+            options.long_iso = true;
+        } else if (token == "--group-directories-first") {
+            options.directories_first = true;
+        } else if (token.compare(0, 2, "--") == 0) {
+            return false;
+        } else if (token.size() > 1 && token[0] == '-') {
+            for (size_t j = 1; j < token.size(); j++) {
+                switch (token[j]) {
+                case 'R': options.recursive = true; break;
+                case 'a': options.all = true; break;
+                case 'A': options.almost_all = true; break;
+                case 'l': options.long_format = true; break;
+                case 'U': options.sort = dir_sort::none; break;
+                case 'S': options.sort = dir_sort::size; break;
+                case 't': options.sort = dir_sort::time; break;
+                case 'X': options.sort = dir_sort::extension; break;
+                case 'r': options.reverse = true; break;
+                case '1': break;
+                default: return false;
+                }
+            }
+        } else if (token.find_first_of("*?[]{}~$`|;&<>()'\"\\") != std::string::npos) {
+            return false;
+        } else {
+            options.paths.push_back(token);
+        }
+    }
+    if (options.paths.empty()) {
+        options.paths.push_back(".");
+    }
+    return options.recursive;
+}
+
+dir_lister::dir_lister(const dir_options_t& options, unsigned int threads)
+    : options(options), threads(threads), finished(false), aborted(false), first_block(true) {
+    if (this->threads == 0) {
+        this->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < this->threads; i++) {
+        queues.emplace_back(new work_queue());
+    }
+}
+
+static std::string join_path(const std::string& dir, const std::string& name) {
+    if (!dir.empty() && dir.back() == '/') {
+        return dir + name;
+    }
+    return dir + "/" + name;
+}
+
+bool dir_lister::run(sink_t output) {
+    sink = output;
+    now = time(nullptr);
+
+    std::vector<entry> files;
+    std::vector<entry> dirs;
+    for (const auto& path : options.paths) {
+        struct stat st;
+        int res = options.long_format ? lstat(path.c_str(), &st) : stat(path.c_str(), &st);
+        if (res != 0 && lstat(path.c_str(), &st) != 0) {
+            fprintf(stderr, "ls: cannot access '%s': %s\n", path.c_str(), strerror(errno));
+            continue;
+        }
+        entry e;
+        e.name = path;
+        e.type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : DT_REG;
+        e.mode = st.st_mode;
+        e.nlink = st.st_nlink;
+        e.uid = st.st_uid;
+        e.gid = st.st_gid;
+        e.size = st.st_size;
+        e.blocks = st.st_blocks;
+        e.mtime = st.st_mtim.tv_sec;
+        e.mtime_nsec = st.st_mtim.tv_nsec;
+        e.link_dir = false;
+        if (options.long_format && S_ISLNK(st.st_mode)) {
+            char target[PATH_MAX];
+            ssize_t len = readlink(path.c_str(), target, sizeof(target));
+            e.link.assign(target, len > 0 ? len : 0);
+            struct stat target_st;
+            e.link_dir = options.directories_first && stat(path.c_str(), &target_st) == 0 && S_ISDIR(target_st.st_mode);
+        }
+        (e.type == DT_DIR ? dirs : files).push_back(std::move(e));
+    }
+    entry_list file_list;
+    for (const auto& e : files) {
+        file_list.push_back(&e);
+    }
+    entry_list dir_list;
+    for (const auto& e : dirs) {
+        dir_list.push_back(&e);
+    }
+    if (options.sort != dir_sort::none) {
+        sort_entries(file_list);
+        sort_entries(dir_list);
+    }
+    if (!files.empty()) {
+        // like ls, the directory arguments count towards the column widths
+        entry_list measured(file_list);
+        measured.insert(measured.end(), dir_list.begin(), dir_list.end());
+        std::string block;
+        format_entries(file_list, false, block, &measured);
+        emit_block(block);
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(&dir_lister::work, this, i);
+    }
+
+    // Blocks are written depth first in both modes, the way ls -R and
+    // ls -RU do. Only the directories nearest the top of the stack are
+    // handed to the workers, so at most `window` listings wait in memory.
+    std::vector<std::shared_ptr<node>> stack;
+    for (auto it = dir_list.rbegin(); it != dir_list.rend(); ++it) {
+        stack.push_back(std::make_shared<node>());
+        stack.back()->path = (*it)->name;
+    }
+    size_t window = std::max<size_t>(DIR_LISTER_WINDOW, threads);
+    size_t in_flight = 0;
+    unsigned int next_worker = 0;
+    while (!stack.empty() && !aborted) {
+        size_t scanned = 0;
+        for (auto it = stack.rbegin(); it != stack.rend() && in_flight < window && scanned < window; ++it, scanned++) {
+            if (!(*it)->dispatched) {
+                (*it)->dispatched = true;
+                in_flight++;
+                push(next_worker++ % threads, *it);
+            }
+        }
+
+        std::shared_ptr<node> n = std::move(stack.back());
+        stack.pop_back();
+        {
+            std::unique_lock<std::mutex> lock(emit_mutex);
+            emit_cv.wait(lock, [&n, this] { return n->listed || aborted; });
+        }
+        in_flight--;
+        emit_block(n->block);
+        stack.insert(stack.end(), n->children.rbegin(), n->children.rend());
+    }
+
+    finished = true;
+    idle_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    flush();
+    return !aborted;
+}
+
+void dir_lister::push(unsigned int worker, std::shared_ptr<node> n) {
+    {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        queues[worker]->nodes.push_back(std::move(n));
+    }
+    idle_cv.notify_one();
+}
+
+std::shared_ptr<dir_lister::node> dir_lister::take(unsigned int worker) {
+    // oldest first: the emitter queues nodes in the order it will need them
+    std::shared_ptr<node> n;
+    for (unsigned int i = 0; i < threads; i++) {
+        work_queue& queue = *queues[(worker + i) % threads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.nodes.empty()) {
+            n = std::move(queue.nodes.front());
+            queue.nodes.pop_front();
+            return n;
+        }
+    }
+    return n;
+}
+
+void dir_lister::work(unsigned int worker) {
+    while (!aborted) {
+        std::shared_ptr<node> n = take(worker);
+        if (n) {
+            list_node(n);
+        } else if (finished) {
+            break;
+        } else {
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            idle_cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void dir_lister::list_node(const std::shared_ptr<node>& n) {
+    std::vector<entry> entries;
+    bool readable = read_entries(n->path, entries);
+    if (!readable) {
+        fprintf(stderr, "ls: cannot open directory '%s': %s\n", n->path.c_str(), strerror(errno));
+    }
+    entry_list list;
+    list.reserve(entries.size());
+    for (const auto& e : entries) {
+        list.push_back(&e);
+    }
+    if (options.sort != dir_sort::none) {
+        sort_entries(list);
+    }
+
+    std::string block = n->path + ":\n";
+    format_entries(list, readable, block);
+
+    std::vector<std::shared_ptr<node>> children;
+    for (const entry* e : list) {
+        if (e->type == DT_DIR && e->name != "." && e->name != "..") {
+            children.push_back(std::make_shared<node>());
+            children.back()->path = join_path(n->path, e->name);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(emit_mutex);
+        n->block = std::move(block);
+        n->children = std::move(children);
+        n->listed = true;
+    }
+    emit_cv.notify_all();
+}
+
+bool dir_lister::needs_stat() const {
+    return options.long_format || options.sort == dir_sort::size || options.sort == dir_sort::time;
+}
+
+bool dir_lister::read_entries(const std::string& path, std::vector<entry>& entries) {
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    unsigned int mask = STATX_TYPE;
+    if (needs_stat()) {
+        mask |= STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_SIZE | STATX_BLOCKS | STATX_MTIME;
+    }
+    std::vector<char> buf(DIR_LISTER_GETDENTS_SIZE);
+    ssize_t size;
+    while ((size = getdents64(fd, buf.data(), buf.size())) > 0) {
+        for (ssize_t offset = 0; offset < size; ) {
+            struct dirent64* d = (struct dirent64 *)(buf.data() + offset);
+            offset += d->d_reclen;
+
+            const char* name = d->d_name;
+            if (name[0] == '.') {
+                bool dots = name[1] == '\0' || (name[1] == '.' && name[2] == '\0');
+                if (!(options.all || options.almost_all) || (dots && !options.all)) {
+                    continue;
+                }
+            }
+
+            entry e;
+            e.name = name;
+            e.type = d->d_type;
+            e.link_dir = false;
+            if (needs_stat() || e.type == DT_UNKNOWN) {
+                struct statx stx;
+                if (statx(fd, name, AT_SYMLINK_NOFOLLOW, mask, &stx) == 0) {
+                    e.type = IFTODT(stx.stx_mode);
+                    e.mode = stx.stx_mode;
+                    e.nlink = stx.stx_nlink;
+                    e.uid = stx.stx_uid;
+                    e.gid = stx.stx_gid;
+                    e.size = stx.stx_size;
+                    e.blocks = stx.stx_blocks;
+                    e.mtime = stx.stx_mtime.tv_sec;
+                    e.mtime_nsec = stx.stx_mtime.tv_nsec;
+                } else {
+                    e.mode = DTTOIF(e.type);
+                    e.nlink = 0;
+                    e.uid = 0;
+                    e.gid = 0;
+                    e.size = 0;
+                    e.blocks = 0;
+                    e.mtime = 0;
+                    e.mtime_nsec = 0;
+                }
+                if (options.long_format && e.type == DT_LNK) {
+                    char target[PATH_MAX];
+                    ssize_t len = readlinkat(fd, name, target, sizeof(target));
+                    e.link.assign(target, len > 0 ? len : 0);
+                }
+            }
+            if (options.directories_first && e.type == DT_LNK) {
+                // ls groups symlinks to directories with the directories
+                struct stat st;
+                e.link_dir = fstatat(fd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+            }
+            entries.push_back(std::move(e));
+        }
+    }
+    int err = errno;
+    close(fd);
+    errno = err;
+    return size == 0;
+}
+
+// Same order as GNU ls in the C locale: the key, then the name, with -r
+// reversing both.
+int dir_lister::compare(const entry* a, const entry* b) const {
+    int diff = 0;
+    switch (options.sort) {
+    case dir_sort::size:
+        diff = a->size < b->size ? 1 : a->size > b->size ? -1 : 0;
+        break;
+    case dir_sort::time:
+        if (a->mtime != b->mtime) {
+            diff = a->mtime < b->mtime ? 1 : -1;
+        } else if (a->mtime_nsec != b->mtime_nsec) {
+            diff = a->mtime_nsec < b->mtime_nsec ? 1 : -1;
+        }
+        break;
+    case dir_sort::extension: {
+        const char* ext_a = strrchr(a->name.c_str(), '.');
+        const char* ext_b = strrchr(b->name.c_str(), '.');
+        diff = strcmp(ext_a ? ext_a : "", ext_b ? ext_b : "");
+        break;
+    }
+    default:
+        break;
+    }
+    if (diff == 0) {
+        diff = strcmp(a->name.c_str(), b->name.c_str());
+    }
+    return options.reverse ? -diff : diff;
+}
+
+bool dir_lister::before(const entry* a, const entry* b) const {
+    if (options.directories_first) {
+        bool dir_a = a->type == DT_DIR || a->link_dir;
+        bool dir_b = b->type == DT_DIR || b->link_dir;
+        if (dir_a != dir_b) {
+            return dir_a;
+        }
+    }
+    return compare(a, b) < 0;
+}
+
+void dir_lister::sort_entries(entry_list& entries) {
+    auto by_key = [this](const entry* a, const entry* b) {
+        return before(a, b);
+    };
+    size_t parts = std::min<size_t>(threads, entries.size() / (DIR_LISTER_PARALLEL_SORT_MIN / 2));
+    if (entries.size() < DIR_LISTER_PARALLEL_SORT_MIN || parts < 2) {
+        std::sort(entries.begin(), entries.end(), by_key);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= parts; i++) {
+        bounds.push_back(entries.size() * i / parts);
+    }
+    std::vector<std::thread> sorters;
+    for (size_t i = 0; i < parts; i++) {
+        sorters.emplace_back([&entries, &bounds, &by_key, i] {
+            std::sort(entries.begin() + bounds[i], entries.begin() + bounds[i + 1], by_key);
+        });
+    }
+    for (auto& sorter : sorters) {
+        sorter.join();
+    }
+    for (size_t width = 1; width < parts; width *= 2) {
+        std::vector<std::thread> mergers;
+        for (size_t i = 0; i + width < parts; i += 2 * width) {
+            size_t last = std::min(i + 2 * width, parts);
+            mergers.emplace_back([&entries, &bounds, &by_key, i, width, last] {
+                std::inplace_merge(entries.begin() + bounds[i], entries.begin() + bounds[i + width],
+                                   entries.begin() + bounds[last], by_key);
+            });
+        }
+        for (auto& merger : mergers) {
+            merger.join();
+        }
+    }
+}
+
+static void format_mode(mode_t mode, std::string& out) {
+    char type = '-';
+    if (S_ISDIR(mode)) type = 'd';
+    else if (S_ISLNK(mode)) type = 'l';
+    else if (S_ISCHR(mode)) type = 'c';
+    else if (S_ISBLK(mode)) type = 'b';
+    else if (S_ISFIFO(mode)) type = 'p';
+    else if (S_ISSOCK(mode)) type = 's';
+    out += type;
+    out += mode & S_IRUSR ? 'r' : '-';
+    out += mode & S_IWUSR ? 'w' : '-';
+    out += mode & S_ISUID ? (mode & S_IXUSR ? 's' : 'S') : (mode & S_IXUSR ? 'x' : '-');
+    out += mode & S_IRGRP ? 'r' : '-';
+    out += mode & S_IWGRP ? 'w' : '-';
+    out += mode & S_ISGID ? (mode & S_IXGRP ? 's' : 'S') : (mode & S_IXGRP ? 'x' : '-');
+    out += mode & S_IROTH ? 'r' : '-';
+    out += mode & S_IWOTH ? 'w' : '-';
+    out += mode & S_ISVTX ? (mode & S_IXOTH ? 't' : 'T') : (mode & S_IXOTH ? 'x' : '-');
+}
+
+static void pad(std::string& out, const std::string& field, size_t width, bool left) {
+    if (left) {
+        out += field;
+        out.append(width - field.size(), ' ');
+    } else {
+        out.append(width - field.size(), ' ');
+        out += field;
+    }
+}
+
+void dir_lister::format_entries(const entry_list& entries, bool with_total, std::string& out,
+                                const entry_list* measured) {
+    if (!options.long_format) {
+        for (const entry* e : entries) {
+            out += e->name;
+            out += '\n';
+        }
+        return;
+    }
+
+    size_t nlink_width = 0, user_width = 0, group_width = 0, size_width = 0;
+    unsigned long long blocks = 0;
+    for (const entry* e : measured ? *measured : entries) {
+        nlink_width = std::max(nlink_width, std::to_string(e->nlink).size());
+        user_width = std::max(user_width, user_name(e->uid).size());
+        group_width = std::max(group_width, group_name(e->gid).size());
+        size_width = std::max(size_width, std::to_string(e->size).size());
+        blocks += e->blocks;
+    }
+    if (with_total) {
+        out += "total " + std::to_string((blocks + 1) / 2) + "\n";
+    }
+
+    for (const entry* e : entries) {
+        char date[32];
+        struct tm tm;
+        localtime_r(&e->mtime, &tm);
+        if (options.long_iso) {
+            strftime(date, sizeof(date), "%Y-%m-%d %H:%M", &tm);
+        } else if (e->mtime <= now && now - e->mtime < 15778476) {
+            strftime(date, sizeof(date), "%b %e %H:%M", &tm);
+        } else {
+            strftime(date, sizeof(date), "%b %e  %Y", &tm);
+        }
+
+        format_mode(e->mode, out);
+        out += ' ';
+        pad(out, std::to_string(e->nlink), nlink_width, false);
+        out += ' ';
+        pad(out, user_name(e->uid), user_width, true);
+        out += ' ';
+        pad(out, group_name(e->gid), group_width, true);
+        out += ' ';
+        pad(out, std::to_string(e->size), size_width, false);
+        out += ' ';
+        out += date;
+        out += ' ';
+        out += e->name;
+        if (e->type == DT_LNK && !e->link.empty()) {
+            out += " -> ";
+            out += e->link;
+        }
+        out += '\n';
+    }
+}
+
+const std::string& dir_lister::user_name(uid_t uid) {
+    std::lock_guard<std::mutex> lock(name_mutex);
+    auto it = users.find(uid);
+    if (it == users.end()) {
+        struct passwd pwd;
+        struct passwd* res = nullptr;
+        char buf[1024];
+        getpwuid_r(uid, &pwd, buf, sizeof(buf), &res);
+        it = users.emplace(uid, res ? std::string(res->pw_name) : std::to_string(uid)).first;
+    }
+    return it->second;
+}
+
+const std::string& dir_lister::group_name(gid_t gid) {
+    std::lock_guard<std::mutex> lock(name_mutex);
+    auto it = groups.find(gid);
+    if (it == groups.end()) {
+        struct group grp;
+        struct group* res = nullptr;
+        char buf[1024];
+        getgrgid_r(gid, &grp, buf, sizeof(buf), &res);
+        it = groups.emplace(gid, res ? std::string(res->gr_name) : std::to_string(gid)).first;
+    }
+    return it->second;
+}
+
+void dir_lister::emit_block(const std::string& block) {
+    if (!first_block) {
+        batch += '\n';
+    }
+    first_block = false;
+    batch += block;
+    if (batch.size() >= DIR_LISTER_BATCH_SIZE) {
+        flush();
+    }
+}
+
+bool dir_lister::flush() {
+    if (!batch.empty() && !aborted) {
+        if (!sink(batch.data(), batch.size())) {
+            aborted = true;
+            emit_cv.notify_all();
+        }
+    }
+    batch.clear();
+    return !aborted;
+}
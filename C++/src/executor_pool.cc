@@ -0,0 +1,224 @@
+#include "executor_pool.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+static bool send_fd(int sock, const void* data, size_t size, int fd) {
+    iovec iov = { (void *)data, size };
+    char control[CMSG_SPACE(sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == (ssize_t)size;
+}
+
+static ssize_t recv_fd(int sock, void* data, size_t size, int* fd, int flags) {
+    iovec iov = { data, size };
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t res = recvmsg(sock, &msg, flags | MSG_CMSG_CLOEXEC);
+    *fd = -1;
+    cmsghdr* cmsg = res > 0 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        std::memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    return res;
+}
+
+executor_pool::executor_pool(runner_t runner, unsigned int min_size, unsigned int max_size)
+    : runner(runner), min_size(min_size), max_size(std::max(min_size, max_size)), target(min_size),
+      requested(0), spawner_pid(-1), control_fd(-1) { }
+
+executor_pool::~executor_pool() {
+    for (auto& e : idle) {
+        close(e.fd);
+    }
+    if (control_fd != -1) {
+        close(control_fd);
+        waitpid(spawner_pid, nullptr, 0);
+    }
+}
+
+bool executor_pool::start() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+        return false;
+    }
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    else if (pid == 0) {
+        // commands already handed out must not outlive a crashed backend:
+        // the spawner dies with it, and each executor with the spawner
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parent) {
+            _exit(EXIT_FAILURE);
+        }
+        close(fds[0]);
+        spawner_main(fds[1]);
+        _exit(EXIT_SUCCESS);
+    }
+    close(fds[1]);
+    control_fd = fds[0];
+    spawner_pid = pid;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    replenish();
+    return true;
+}
+
+void executor_pool::spawner_main(int fd) {
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+    pid_t spawner = getpid();
+    uint32_t count;
+    while (recv(fd, &count, sizeof(count), 0) == sizeof(count)) {
+        for (uint32_t i = 0; i < count; i++) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) == -1) {
+                break;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                prctl(PR_SET_PDEATHSIG, SIGKILL);
+                if (getppid() != spawner) {
+                    _exit(EXIT_FAILURE);
+                }
+                close(fd);
+                close(pair[0]);
+                signal(SIGCHLD, SIG_DFL);
+                signal(SIGPIPE, SIG_DFL);
+                executor_main(pair[1]);
+                _exit(EXIT_FAILURE);
+            }
+            close(pair[1]);
+            if (pid > 0) {
+                send_fd(fd, &pid, sizeof(pid), pair[0]);
+            }
+            close(pair[0]);
+        }
+    }
+}
+
+void executor_pool::executor_main(int fd) {
+    char request[PATH_MAX + MESSAGE_DATA_SIZE];
+    int out;
+    ssize_t size = recv_fd(fd, request, sizeof(request), &out, 0);
+    if (size <= 0 || out == -1) {
+        _exit(EXIT_FAILURE);
+    }
+    close(fd);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+
+    std::string program(request, strnlen(request, size));
+    std::string command(request + std::min<size_t>(program.size() + 1, size), request + size);
+    runner(command, program);
+    fflush(stdout);
+    _exit(EXIT_SUCCESS);
+}
+
+void executor_pool::replenish() {
+    size_t have = idle.size() + requested;
+    if (control_fd == -1 || have >= target) {
+        return;
+    }
+    uint32_t count = target - have;
+    if (send(control_fd, &count, sizeof(count), MSG_NOSIGNAL) == sizeof(count)) {
+        requested += count;
+    }
+}
+
+bool executor_pool::collect(bool wait) {
+    int flags = wait ? 0 : MSG_DONTWAIT;
+    while (requested > 0) {
+        pid_t pid;
+        int fd;
+        if (recv_fd(control_fd, &pid, sizeof(pid), &fd, flags) != sizeof(pid)) {
+            break;
+        }
+        requested--;
+        if (fd != -1) {
+            idle.push_back({ pid, fd });
+        }
+        flags = MSG_DONTWAIT;
+    }
+    return !idle.empty();
+}
+
+void executor_pool::resize(size_t concurrency) {
+    std::lock_guard<std::mutex> lock(mutex);
+    target = std::min<size_t>(max_size, std::max<size_t>(min_size, concurrency));
+    replenish();
+}
+
+size_t executor_pool::available() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (control_fd != -1) {
+        collect(false);
+    }
+    return idle.size();
+}
+
+FILE* executor_pool::run(const std::string& command, const std::string& program, const dispatch_t& on_dispatch) {
+    std::string request = program;
+    request += '\0';
+    request.append(command, 0, MESSAGE_DATA_SIZE);
+    std::unique_lock<std::mutex> lock(mutex);
+    if (control_fd == -1) {
+        return nullptr;
+    }
+
+    while (true) {
+        collect(false);
+        if (idle.empty()) {
+            replenish();
+            if (!collect(true)) {
+                return nullptr;
+            }
+        }
+        executor e = idle.front();
+        idle.pop_front();
+        replenish();
+
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) == -1) {
+            close(e.fd);
+            return nullptr;
+        }
+        if (on_dispatch) {
+            on_dispatch(e.pid);
+        }
+        bool sent = send_fd(e.fd, request.data(), request.size(), fds[1]);
+        close(fds[1]);
+        close(e.fd);
+        if (sent) {
+            return fdopen(fds[0], "r");
+        }
+        close(fds[0]);
+    }
+}
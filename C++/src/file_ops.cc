@@ -0,0 +1,269 @@
+#include "file_ops.hh"
+#include "uring.hh"
+
+#include <cstring>
+#include <thread>
+#include <glob.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+constexpr const int FILE_OP_PENDING = 1;
+
+static std::string quote(const std::string& path) {
+    return "'" + path + "'";
+}
+
+static std::string shell_quote(const std::string& path) {
+    std::string res("'");
+    for (auto c : path) {
+        if (c == '\'') {
+            res += "'\\''";
+        } else {
+            res += c;
+        }
+    }
+    return res + "'";
+}
+
+static std::string base_name(std::string path) {
+    while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+    std::string::size_type pos = path.rfind('/');
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+bool file_ops::parse(const std::string& command, file_ops_options_t& options) {
+    std::vector<std::string> tokens;
+    std::string::size_type pos = 0;
+    while (pos < command.size()) {
+        std::string::size_type end = command.find(' ', pos);
+        if (end == std::string::npos) {
+            end = command.size();
+        }
+        if (end > pos) {
+            tokens.push_back(command.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    if (tokens.empty() || (tokens[0] != "rm" && tokens[0] != "mv")) {
+        return false;
+    }
+    options.move = tokens[0] == "mv";
+
+    bool operands = false;
+    for (size_t i = 1; i < tokens.size(); i++) {
+        const std::string& token = tokens[i];
+        if (!operands && token == "--") {
+            operands = true;
+        } else if (!operands && token.size() > 1 && token[0] == '-') {
+            for (size_t j = 1; j < token.size(); j++) {
+                switch (token[j]) {
+                case 'f': options.force = true; break;
+                case 'v': options.verbose = true; break;
+                case 'n':
+                    if (!options.move) {
+                        return false;
+                    }
+                    options.no_clobber = true;
+                    break;
+                default: return false;
+                }
+            }
+        } else if (token.find_first_of("$`|;&<>()'\"\\~{}") != std::string::npos) {
+            return false;
+        } else if (token.find_first_of("*?[") != std::string::npos) {
+            glob_t matches;
+            if (glob(token.c_str(), GLOB_NOCHECK, nullptr, &matches) != 0) {
+                globfree(&matches);
+                return false;
+            }
+            for (size_t j = 0; j < matches.gl_pathc; j++) {
+                options.args.push_back(matches.gl_pathv[j]);
+            }
+            globfree(&matches);
+        } else {
+            options.args.push_back(token);
+        }
+    }
+    return options.args.size() >= (options.move ? 2u : 1u);
+}
+
+file_ops::file_ops(const file_ops_options_t& options, unsigned int batch_size, unsigned int threads, bool use_uring)
+    : options(options), batch_size(batch_size), threads(threads), use_uring(use_uring) {
+    if (this->threads == 0) {
+        this->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+bool file_ops::plan(std::string& report) {
+    if (!options.move) {
+        for (const auto& arg : options.args) {
+            ops.push_back({ file_op_kind::unlink, arg, std::string(), FILE_OP_PENDING });
+        }
+        return true;
+    }
+
+    std::string target = options.args.back();
+    struct stat st;
+    bool target_dir = stat(target.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    if (options.args.size() > 2 && !target_dir) {
+        report += "mv: target " + quote(target) + " is not a directory\n";
+        return false;
+    }
+    for (size_t i = 0; i + 1 < options.args.size(); i++) {
+        const std::string& source = options.args[i];
+        std::string path = target;
+        if (target_dir) {
+            path += (path.back() == '/' ? "" : "/") + base_name(source);
+        }
+        ops.push_back({ file_op_kind::rename, source, path, FILE_OP_PENDING });
+    }
+    return true;
+}
+
+bool file_ops::run_uring() {
+    uring ring(batch_size);
+    if (!ring.valid() || !ring.supports(IORING_OP_UNLINKAT) || !ring.supports(IORING_OP_RENAMEAT)) {
+        return false;
+    }
+
+    unsigned int flags = options.no_clobber ? RENAME_NOREPLACE : 0;
+    size_t next = 0;
+    size_t inflight = 0;
+    auto reap = [this, &ring, &inflight] {
+        io_uring_cqe cqe;
+        while (ring.peek(cqe)) {
+            ops[cqe.user_data].result = cqe.res;
+            inflight--;
+        }
+    };
+    while (next < ops.size() || inflight > 0) {
+        io_uring_sqe* sqe;
+        while (next < ops.size() && inflight < ring.completion_capacity() && (sqe = ring.get_sqe()) != nullptr) {
+            file_op_t& op = ops[next];
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (unsigned long)op.source.c_str();
+            sqe->user_data = next;
+            if (op.kind == file_op_kind::unlink) {
+                sqe->opcode = IORING_OP_UNLINKAT;
+            } else {
+                sqe->opcode = IORING_OP_RENAMEAT;
+                sqe->len = AT_FDCWD;
+                sqe->addr2 = (unsigned long)op.target.c_str();
+                sqe->rename_flags = flags;
+            }
+            next++;
+            inflight++;
+        }
+        if (ring.submit(1) < 0 && errno != EINTR) {
+            // The kernel owns what it already consumed; let those finish
+            // and leave only the ops it never saw to the thread path.
+            int err = errno;
+            unsigned int unsubmitted = ring.cancel_unsubmitted();
+            next -= unsubmitted;
+            inflight -= unsubmitted;
+            for (reap(); inflight > 0; reap()) {
+                if (ring.submit(1) < 0 && errno != EINTR) {
+                    for (size_t i = 0; i < next; i++) {
+                        if (ops[i].result == FILE_OP_PENDING) {
+                            ops[i].result = -err;
+                        }
+                    }
+                    break;
+                }
+            }
+            return false;
+        }
+        reap();
+    }
+    return true;
+}
+
+void file_ops::run_threads() {
+    unsigned int flags = options.no_clobber ? RENAME_NOREPLACE : 0;
+    auto worker = [this, flags](size_t first) {
+        for (size_t i = first; i < ops.size(); i += threads) {
+            file_op_t& op = ops[i];
+            if (op.result != FILE_OP_PENDING) {
+                continue;
+            }
+            int res = op.kind == file_op_kind::unlink
+                ? unlink(op.source.c_str())
+                : renameat2(AT_FDCWD, op.source.c_str(), AT_FDCWD, op.target.c_str(), flags);
+            op.result = res == 0 ? 0 : -errno;
+        }
+    };
+    if (threads == 1 || ops.size() < batch_size) {
+        for (size_t i = 0; i < std::min<size_t>(threads, ops.size()); i++) {
+            worker(i);
+        }
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threads; i++) {
+        pool.emplace_back(worker, i);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+bool file_ops::fallback_move(const file_op_t& op, std::string& report) {
+    std::string command = std::string("mv -f") + (options.no_clobber ? "n" : "") + " -- "
+        + shell_quote(op.source) + " " + shell_quote(op.target) + " 2>&1";
+    FILE *fp = popen(command.c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    char buf[1024];
+    size_t size;
+    while ((size = fread(buf, sizeof(char), sizeof(buf), fp)) > 0) {
+        report.append(buf, size);
+    }
+    return pclose(fp) == 0;
+}
+
+bool file_ops::run(sink_t sink) {
+    std::string report;
+    if (plan(report)) {
+        if (!use_uring || !run_uring()) {
+            run_threads();
+        }
+    }
+
+    for (const auto& op : ops) {
+        int err = -op.result;
+        if (op.kind == file_op_kind::unlink) {
+            if (err == 0) {
+                if (options.verbose) {
+                    report += "removed " + quote(op.source) + "\n";
+                }
+            } else if (!(options.force && err == ENOENT)) {
+                report += "rm: cannot remove " + quote(op.source) + ": " + strerror(err) + "\n";
+            }
+        } else {
+            if (err == EXDEV && fallback_move(op, report)) {
+                err = 0;
+            }
+            if (err == 0) {
+                if (options.verbose) {
+                    report += "renamed " + quote(op.source) + " -> " + quote(op.target) + "\n";
+                }
+            } else if (err == ENOENT && access(op.source.c_str(), F_OK) != 0) {
+                report += "mv: cannot stat " + quote(op.source) + ": " + strerror(err) + "\n";
+            } else if (!(options.no_clobber && err == EEXIST) && err != EXDEV) {
+                report += "mv: cannot move " + quote(op.source) + " to " + quote(op.target) + ": " + strerror(err) + "\n";
+            }
+        }
+        if (report.size() >= PIPE_BUFFER_SIZE) {
+            if (!sink(report.data(), report.size())) {
+                return false;
+            }
+            report.clear();
+        }
+    }
+    return report.empty() || sink(report.data(), report.size());
+}
@@ -1,97 +1,210 @@
 #include "definations.hh"
 #include "message_queue.hh"
+#include "heavy_slots.hh"
+#include "memory_transport.hh"
+#include "backend.hh"
+#include "supervisor.hh"
 #include "named_pipe.hh"
 #include "converter.hh"
+#include "trace.hh"
+#include "probes.hh"
 
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <functional>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/wait.h>
+#include <limits.h>
 
-void app(bool verbose = false);
-void frontend(pid_t pid, bool verbose);
+void app(bool verbose = false, bool in_process = false, codec_type codec = codec_type::none,
+         bool cmd_format = false, bool perf = false, const char* record_path = nullptr);
+void frontend(transport& msq, supervisor* sup, std::function<void ()> stop_backend, bool verbose,
+              codec_type codec, bool cmd_format, bool perf, const char* record_path);
+void negotiate(transport& msq, named_pipe& np, long session, codec_type codec, bool cmd_format, bool perf, bool verbose);
+bool recover(transport& msq, supervisor& sup, named_pipe& np, long session,
+             codec_type codec, bool cmd_format, bool perf, bool verbose);
 
 int main(int argc, char *argv[]) {
     int ch;
     bool verbose = false;
-    while ((ch = getopt(argc, argv, "v")) != -1) {
+    bool in_process = false;
+    codec_type codec = codec_type::none;
+    bool cmd_format = false;
+    bool perf = false;
+    const char* record_path = nullptr;
+    while ((ch = getopt(argc, argv, "vt:z:f:r:p")) != -1) {
         switch (ch) {
         case 'v':
             verbose = true;
             break;
+        case 't':
+            in_process = std::string(optarg) == "thread";
+            break;
+        case 'z':
+            codec = codec_from_name(optarg);
+            break;
+        case 'f':
+            cmd_format = std::string(optarg) == "cmd";
+            break;
+        case 'r':
+            record_path = optarg;
+            break;
+        case 'p':
+            perf = true;
+            break;
         default:
             std::cout << "Unknown argument: " << ch << std::endl;
             exit(EXIT_FAILURE);
         }
     }
-    app(verbose);
+    app(verbose, in_process, codec, cmd_format, perf, record_path);
     return 0;
 }
 
-void app(bool verbose) {
+void app(bool verbose, bool in_process, codec_type codec, bool cmd_format, bool perf, const char* record_path) {
     if (verbose) {
         std::cout << "[FE] Preparing named pipe..." << std::endl;
     }
-    named_pipe::make_pipe(NAMED_PIPE_PATH);
+    size_t stale_pipes = named_pipe::remove_stale();
+    if (verbose && stale_pipes > 0) {
+        std::cout << "[FE] Removed " << stale_pipes << " stale session pipe(s)" << std::endl;
+    }
+    named_pipe::make_pipe(named_pipe::session_path(getpid()).c_str());
+
+    if (in_process) {
+        if (verbose) {
+            std::cout << "[FE] Starting backend thread..." << std::endl;
+        }
+        memory_transport msq;
+        std::thread backend_thread(backend, std::ref(msq), verbose, nullptr);
+        msq.receive(MESSAGE_TYPE_READY);
+        frontend(msq, nullptr, [&msq, &backend_thread]() {
+            msq.send(MESSAGE_TYPE_EXIT, "");
+            backend_thread.join();
+        }, verbose, codec, cmd_format, perf, record_path);
+        return;
+    }
+
+    if (message_queue::remove_stale(MESSAGE_QUEUE_KEY) && verbose) {
+        std::cout << "[FE] Removed stale message queue" << std::endl;
+    }
+    message_queue msq(MESSAGE_QUEUE_KEY);
 
     if (verbose) {
         std::cout << "[FE] Making child process..." << std::endl;
     }
-    pid_t pid = fork();
-    if (pid < 0) {
-        perror("fork");
+    supervisor sup(msq, getpid(), verbose);
+    if (!sup.start()) {
+        std::cerr << "Backend failed to start" << std::endl;
+        unlink(named_pipe::session_path(getpid()).c_str());
         exit(EXIT_FAILURE);
     }
-    else if (pid == 0) {
-        if (verbose) {
-            execl(BACKEND_PATH, BACKEND_NAME, "-v", NULL);
-        }
-        else {
-            execl(BACKEND_PATH, BACKEND_NAME, NULL);
+    frontend(msq, &sup, [&msq, &sup]() {
+        sup.stop();
+        // other sessions may still be using it; a queue left behind is
+        // cleared by remove_stale() once they are gone
+        if (msq.created() && named_pipe::live_sessions(getpid()) == 0) {
+            msq.destroy();
+            heavy_slots(SCHEDULER_HEAVY_KEY).destroy();
         }
+    }, verbose, codec, cmd_format, perf, record_path);
+}
+
+void negotiate(transport& msq, named_pipe& np, long session, codec_type codec, bool cmd_format, bool perf, bool verbose) {
+    if (codec == codec_type::none && !cmd_format && !perf) {
+        return;
+    }
+    if (verbose) {
+        std::cout << "[FE] Negotiating output codec '" << codec_name(codec) << "'"
+                  << (cmd_format ? " and cmd format" : "") << (perf ? " with perf counters" : "") << "..." << std::endl;
+    }
+    msq.send(MESSAGE_TYPE_SESSION, std::string("codec=") + codec_name(codec) + (cmd_format ? " format=cmd" : "")
+             + (perf ? " perf=on" : ""), session);
+    std::string reply;
+    std::tie(std::ignore, reply) = msq.receive(session_response_type(session));
+    codec = reply.compare(0, 6, "codec=") == 0 ? codec_from_name(reply.substr(6, reply.find(' ') - 6)) : codec_type::none;
+    np.set_codec(codec);
+    if (verbose) {
+        std::cout << "[FE] Backend accepted '" << reply << "'" << std::endl;
+    }
+}
+
+// Restarts a lost backend. Returns true if the request was still queued,
+// i.e. the lost backend never started it. Only this session's request is
+// taken back; other sessions' requests stay queued in order.
+bool recover(transport& msq, supervisor& sup, named_pipe& np, long session,
+             codec_type codec, bool cmd_format, bool perf, bool verbose) {
+    bool queued = false;
+    while (std::get<0>(msq.receive_session(session_request_type(session), false)) != 0) {
+        queued = true;
+    }
+
+    if (!sup.restart()) {
+        std::cerr << "Backend keeps failing, giving up" << std::endl;
+        unlink(named_pipe::session_path(session).c_str());
+        exit(EXIT_FAILURE);
     }
-    else {
-        frontend(pid, verbose);
+    while (std::get<0>(msq.receive_session(session_response_type(session), false)) != 0) { }
+    np.reset();
+    np.set_peer(sup.liveness_fd());
+    negotiate(msq, np, session, codec, cmd_format, perf, verbose);
+    if (verbose) {
+        std::cout << "[FE] Backend restarted" << std::endl;
     }
+    return queued;
 }
 
-void frontend(pid_t pid, bool verbose) {
-    converter conv;
+void frontend(transport& msq, supervisor* sup, std::function<void ()> stop_backend, bool verbose,
+              codec_type codec, bool cmd_format, bool perf, const char* record_path) {
+    char cwd[PATH_MAX];
+    path_translator paths(getcwd(cwd, sizeof(cwd)) ? cwd : "/");
+    converter conv(cmd_format, &paths);
     std::string command;
+    long session = getpid();
+    std::string pipe_path = named_pipe::session_path(session);
 
     if (verbose) {
         std::cout << "[FE] Preparing IPC..." << std::endl;
     }
-    named_pipe np(NAMED_PIPE_PATH, O_RDONLY | O_NONBLOCK);
-    message_queue msq(MESSAGE_QUEUE_KEY);
+    named_pipe np(pipe_path.c_str(), O_RDWR | O_NONBLOCK);
+    if (sup) {
+        np.set_peer(sup->liveness_fd());
+    }
+    negotiate(msq, np, session, codec, cmd_format, perf, verbose);
 
-    if (verbose) {
-        std::cout << "[FE] Waiting for backend..." << std::endl;
+    std::unique_ptr<trace_writer> recorder;
+    if (record_path) {
+        if (verbose) {
+            std::cout << "[FE] Recording session to '" << record_path << "'..." << std::endl;
+        }
+        recorder.reset(new trace_writer(record_path));
     }
-    msq.receive(MESSAGE_TYPE_READY);
+    auto session_start = std::chrono::steady_clock::now();
 
     if (verbose) {
         std::cout << "[FE] Starting main loop..." << std::endl;
     }
     while (true) {
         std::cout << PROMPT << " ";
-        std::getline(std::cin, command);
+        if (!std::getline(std::cin, command)) {
+            std::cout << std::endl;
+            command = "exit";
+        }
         if (command == "exit") {
             if (verbose) {
-                std::cout << "[FE] Sending shutdown message to backend..." << std::endl;
-            }
-            msq.send(MESSAGE_TYPE_EXIT, "");
-            
-            if (verbose) {
-                std::cout << "[FE] Waiting for backend..." << std::endl;
+                std::cout << "[FE] Stopping backend..." << std::endl;
             }
-            int stat;
-            waitpid(pid, &stat, 0);
+            stop_backend();
 
             if (verbose) {
+                std::cout << "[FE] Path cache: " << paths.total_hits() << " hits, " << paths.total_loads()
+                          << " directory loads, " << paths.total_invalidations() << " invalidations" << std::endl;
                 std::cout << "[FE] Cleaning up..." << std::endl;
             }
-            msq.destroy();
+            unlink(pipe_path.c_str());
+            recorder.reset();
             exit(EXIT_SUCCESS);
         }
         else {
@@ -99,17 +212,60 @@ void frontend(pid_t pid, bool verbose) {
             if (verbose) {
                 std::cout << "[FE] Converted command: '" << command << "'" << std::endl;
             }
-            msq.send(MESSAGE_TYPE_REQUEST, command);
-            
-            if (verbose) {
-                std::cout << "[FE] Waiting for backend response..." << std::endl;
+            auto request_start = std::chrono::steady_clock::now();
+            DS_PROBE(request_start, session, command.c_str());
+            size_t output_size;
+            bool retried = false;
+            while (true) {
+                msq.send(session_request_type(session), command, session);
+
+                if (verbose) {
+                    std::cout << "[FE] Waiting for backend output..." << std::endl;
+                }
+                output_size = np.pipe_to(stdout);
+
+                std::string reply;
+                if (!np.is_broken()) {
+                    if (verbose) {
+                        std::cout << "[FE] Waiting for backend response..." << std::endl;
+                    }
+                    std::tie(std::ignore, reply) = msq.receive(session_response_type(session));
+                }
+                if (!sup || (!np.is_broken() && reply != SUPERVISOR_LOST_MESSAGE)) {
+                    if (sup) {
+                        sup->succeeded();
+                    }
+                    if (perf && !np.trailer().empty()) {
+                        std::cerr << "[perf] " << np.trailer() << std::endl;
+                    }
+                    break;
+                }
+
+                if (verbose) {
+                    std::cout << "[FE] Backend lost while running '" << command << "'" << std::endl;
+                }
+                // a command the lost backend already started may have had
+                // effects, so only a request it never took is sent again
+                bool queued = recover(msq, *sup, np, session, codec, cmd_format, perf, verbose);
+                if (!retried && queued) {
+                    retried = true;
+                    continue;
+                }
+                std::cerr << "Backend exited while running '" << command << "', not retried" << std::endl;
+                break;
             }
-            msq.receive(MESSAGE_TYPE_RESPONSE);
 
-            if (verbose) {
-                std::cout << "[FE] Receving backend response. Printing..." << std::endl;
+            DS_PROBE(request_done, session, output_size,
+                     std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request_start).count());
+            if (recorder) {
+                auto request_end = std::chrono::steady_clock::now();
+                trace_record_t record;
+                record.offset_us = std::chrono::duration_cast<std::chrono::microseconds>(request_start - session_start).count();
+                record.latency_us = std::chrono::duration_cast<std::chrono::microseconds>(request_end - request_start).count();
+                record.output_size = output_size;
+                record.command = command;
+                recorder->write(record);
             }
-            np.pipe_to(stdout);
         }
     }
 }
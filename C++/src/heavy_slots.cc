@@ -0,0 +1,49 @@
+#include "heavy_slots.hh"
+
+#include <cerrno>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/sem.h>
+
+heavy_slots::heavy_slots(key_t key, unsigned int count) : count(count) {
+    sem_id = semget(key, count, 0666 | IPC_CREAT);
+    if (sem_id == -1) {
+        // TODO: Error handling
+        perror("Semaphore");
+        exit(EXIT_FAILURE);
+    }
+}
+
+bool heavy_slots::try_acquire() {
+    for (unsigned short slot = 0; slot < count; slot++) {
+        // free (0) and taken in one step
+        sembuf ops[2] = { { slot, 0, IPC_NOWAIT }, { slot, 1, IPC_NOWAIT | SEM_UNDO } };
+        if (semop(sem_id, ops, 2) == 0) {
+            held.push_back(slot);
+            return true;
+        }
+        if (errno != EAGAIN && errno != EINTR) {
+            perror("semop");
+            return false;
+        }
+    }
+    return false;
+}
+
+void heavy_slots::release() {
+    if (held.empty()) {
+        return;
+    }
+    sembuf op = { held.back(), -1, IPC_NOWAIT | SEM_UNDO };
+    held.pop_back();
+    while (semop(sem_id, &op, 1) == -1 && errno == EINTR) { }
+}
+
+void heavy_slots::destroy() {
+    int res = semctl(sem_id, 0, IPC_RMID);
+    if (res == -1) {
+        // TODO: Error handling
+        perror("semctl");
+        exit(EXIT_FAILURE);
+    }
+}
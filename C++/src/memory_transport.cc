@@ -0,0 +1,154 @@
+#include "memory_transport.hh"
+
+#include <thread>
+#include <climits>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+memory_transport::~memory_transport() {
+    for (auto& ch : channels) {
+        delete ch.queue.load();
+    }
+}
+
+memory_transport::channel* memory_transport::find(long type, bool create) {
+    size_t start = (unsigned long)type % MEMORY_TRANSPORT_CHANNELS;
+    for (size_t i = 0; i < MEMORY_TRANSPORT_CHANNELS; i++) {
+        channel* ch = &channels[(start + i) % MEMORY_TRANSPORT_CHANNELS];
+        long current = ch->type.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (!create) {
+                return nullptr;
+            }
+            if (ch->type.compare_exchange_strong(current, type)) {
+                ch->queue.store(new mpmc_queue<msg_data_t>(MEMORY_TRANSPORT_CAPACITY), std::memory_order_release);
+                return ch;
+            }
+        }
+        if (current == type) {
+            while (!ch->queue.load(std::memory_order_acquire)) {
+                cpu_relax();
+            }
+            return ch;
+        }
+    }
+    return nullptr;
+}
+
+memory_transport::event& memory_transport::event_for(long type) {
+    if (type <= 0) {
+        return control;
+    }
+    return find(type, true)->ev;
+}
+
+bool memory_transport::try_receive(long type, msg_data_t& msg) {
+    if (type > 0) {
+        channel* ch = find(type, false);
+        return ch && ch->queue.load(std::memory_order_acquire)->try_pop(msg);
+    }
+    // lowest type first, like msgrcv; the range is too wide to walk by type
+    long limit = type == 0 ? MESSAGE_TYPE_SESSION_BASE - 1 : -type;
+    channel* candidates[MEMORY_TRANSPORT_CHANNELS];
+    size_t count = 0;
+    for (auto& ch : channels) {
+        long current = ch.type.load(std::memory_order_acquire);
+        if (current > 0 && current <= limit) {
+            candidates[count++] = &ch;
+        }
+    }
+    std::sort(candidates, candidates + count, [](channel* a, channel* b) {
+        return a->type.load(std::memory_order_relaxed) < b->type.load(std::memory_order_relaxed);
+    });
+    for (size_t i = 0; i < count; i++) {
+        auto queue = candidates[i]->queue.load(std::memory_order_acquire);
+        if (queue && queue->try_pop(msg)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void memory_transport::wait(event& ev, const std::function<bool ()>& ready) {
+    uint32_t limit = ev.spin.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < limit; i++) {
+        if (ready()) {
+            ev.spin.store(std::min(limit * 2, MEMORY_TRANSPORT_SPIN_MAX), std::memory_order_relaxed);
+            return;
+        }
+        cpu_relax();
+    }
+    ev.spin.store(std::max(limit / 2, MEMORY_TRANSPORT_SPIN_MIN), std::memory_order_relaxed);
+
+    while (true) {
+        ev.waiters.fetch_add(1);
+        uint32_t seq = ev.seq.load();
+        if (ready()) {
+            ev.waiters.fetch_sub(1);
+            return;
+        }
+        syscall(SYS_futex, &ev.seq, FUTEX_WAIT_PRIVATE, seq, nullptr, nullptr, 0);
+        ev.waiters.fetch_sub(1);
+    }
+}
+
+void memory_transport::notify(event& ev, int count) {
+    ev.seq.fetch_add(1);
+    if (ev.waiters.load() > 0) {
+        syscall(SYS_futex, &ev.seq, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+}
+
+void memory_transport::send(long msg_type, std::string msg_data, long session, long sent) {
+    channel* ch = find(msg_type, true);
+    if (!ch) {
+        // TODO: Error handling
+        fprintf(stderr, "Message send: too many message types\n");
+        exit(EXIT_FAILURE);
+    }
+    msg_data_t msg(msg_type, msg_data, session);
+    if (sent != 0) {
+        msg.sent = sent;
+    }
+    auto queue = ch->queue.load(std::memory_order_acquire);
+    while (!queue->try_push(msg)) {
+        std::this_thread::yield();
+    }
+    // one message satisfies at most one exact-type receiver
+    notify(ch->ev, 1);
+    if (msg_type < MESSAGE_TYPE_SESSION_BASE) {
+        notify(control, INT_MAX);
+    }
+}
+
+std::tuple<long, std::string> memory_transport::receive(long type) {
+    long msg_type;
+    std::string data;
+    std::tie(msg_type, std::ignore, data, std::ignore) = receive_session(type, true);
+    return std::make_tuple(msg_type, data);
+}
+
+std::tuple<long, long, std::string, long> memory_transport::receive_session(long type, bool wait) {
+    msg_data_t msg;
+    if (!try_receive(type, msg)) {
+        if (!wait) {
+            return std::make_tuple(0L, 0L, std::string(), 0L);
+        }
+        this->wait(event_for(type), [this, type, &msg] {
+            return try_receive(type, msg);
+        });
+    }
+    return std::make_tuple(msg.type, msg.session, std::string(msg.data), msg.sent);
+}
+
+void memory_transport::destroy() { }
@@ -1,23 +1,52 @@
 #include "message_queue.hh"
+#include "probes.hh"
 
+#include <cerrno>
 #include <cstring>
+#include <signal.h>
 #include <sys/msg.h>
 
+constexpr const size_t MESSAGE_PAYLOAD_SIZE = sizeof(msg_data_t) - sizeof(long);
+
 _message_data::_message_data()
-    : type(0), data{ 0 } { }
+    : type(0), session(0), sent(0), data{ 0 } { }
 
-_message_data::_message_data(long msg_type, std::string msg_data)
-    : type(msg_type) {
-    msg_data.copy(data, MESSAGE_DATA_SIZE);
+_message_data::_message_data(long msg_type, std::string msg_data, long msg_session)
+    : type(msg_type), session(msg_session), sent(message_clock()), data{ 0 } {
+    msg_data.copy(data, MESSAGE_DATA_SIZE - 1);
 }
 
 _message_data::_message_data(const _message_data& other)
-    : type(other.type) {
+    : type(other.type), session(other.session), sent(other.sent) {
     std::memcpy(data, other.data, MESSAGE_DATA_SIZE);
 }
 
-message_queue::message_queue(key_t key) : msg_key(key) {
-    msg_id = msgget(key, 0666 | IPC_CREAT);
+static bool process_alive(pid_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+bool message_queue::remove_stale(key_t key) {
+    int id = msgget(key, 0);
+    if (id == -1) {
+        return false;
+    }
+    msqid_ds ds;
+    if (msgctl(id, IPC_STAT, &ds) == -1) {
+        return false;
+    }
+    // nobody alive has touched it: left over by a crashed session
+    if (process_alive(ds.msg_lspid) || process_alive(ds.msg_lrpid)) {
+        return false;
+    }
+    return msgctl(id, IPC_RMID, nullptr) == 0;
+}
+
+message_queue::message_queue(key_t key) : msg_key(key), owner(true) {
+    msg_id = msgget(key, 0666 | IPC_CREAT | IPC_EXCL);
+    if (msg_id == -1 && errno == EEXIST) {
+        owner = false;
+        msg_id = msgget(key, 0666);
+    }
     if (msg_id == -1) {
         // TODO: Error handling
         perror("Message queue");
@@ -25,27 +54,48 @@ message_queue::message_queue(key_t key) : msg_key(key) {
     }
 }
 
-void message_queue::send(long msg_type, std::string msg_data) {
-    msg_buf_t buf(msg_type, msg_data);
-    int res = msgsnd(msg_id, buf, MESSAGE_DATA_SIZE, 0);
+void message_queue::send(long msg_type, std::string msg_data, long session, long sent) {
+    msg_buf_t buf(msg_type, msg_data, session);
+    if (sent != 0) {
+        buf->sent = sent;
+    }
+    int res = msgsnd(msg_id, buf, MESSAGE_PAYLOAD_SIZE, 0);
     if (res == -1) {
         // TODO: Error handling
         perror("Message send");
         exit(EXIT_FAILURE);
     }
+    DS_PROBE(msq_send, msg_type, session);
 }
 
 std::tuple<long, std::string> message_queue::receive(long type) {
     msg_buf_t buf;
-    int res = msgrcv(msg_id, buf, MESSAGE_DATA_SIZE, type, 0);
+    int res;
+    while ((res = msgrcv(msg_id, buf, MESSAGE_PAYLOAD_SIZE, type, 0)) == -1 && errno == EINTR) { }
     if (res == -1) {
         // TODO: Error handling
         perror("Message receive");
         exit(EXIT_FAILURE);
     }
+    DS_PROBE(msq_receive, buf->type, buf->session);
     return std::make_tuple(buf->type, buf->data);
 }
 
+std::tuple<long, long, std::string, long> message_queue::receive_session(long type, bool wait) {
+    msg_buf_t buf;
+    int res = msgrcv(msg_id, buf, MESSAGE_PAYLOAD_SIZE, type, wait ? 0 : IPC_NOWAIT);
+    if (res == -1) {
+        if ((!wait && errno == ENOMSG) || (wait && errno == EINTR)) {
+            return std::make_tuple(0L, 0L, std::string(), 0L);
+        }
+        // TODO: Error handling
+        perror("Message receive");
+        exit(EXIT_FAILURE);
+    }
+    DS_PROBE(msq_receive, buf->type, buf->session);
+    return std::make_tuple(buf->type, buf->session, std::string(buf->data), buf->sent);
+}
+
 void message_queue::destroy() {
     int res = msgctl(msg_id, IPC_RMID, nullptr);
     if (res == -1) {
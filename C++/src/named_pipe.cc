@@ -1,10 +1,17 @@
 #include "named_pipe.hh"
+#include "probes.hh"
+#include "message_queue.hh"
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
 
 void named_pipe::make_pipe(const char* pipe_path) {
     if (access(pipe_path, F_OK) == 0) {
@@ -18,7 +25,70 @@ void named_pipe::make_pipe(const char* pipe_path) {
     }
 }
 
-named_pipe::named_pipe(const char* pipe_path, int mode) {
+std::string named_pipe::session_path(long session) {
+    return std::string(NAMED_PIPE_PATH) + "." + std::to_string(session);
+}
+
+static bool process_alive(pid_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+void named_pipe::for_each_session(const std::function<void (const std::string&, long)>& visit) {
+    std::string path(NAMED_PIPE_PATH);
+    std::string dir = path.substr(0, path.rfind('/'));
+    std::string prefix = path.substr(path.rfind('/') + 1) + ".";
+    DIR *dp = opendir(dir.c_str());
+    if (!dp) {
+        return;
+    }
+    while (dirent *entry = readdir(dp)) {
+        if (strncmp(entry->d_name, prefix.c_str(), prefix.size()) != 0) {
+            continue;
+        }
+        char *end;
+        long session = strtol(entry->d_name + prefix.size(), &end, 10);
+        if (*end == '\0' && session > 0) {
+            visit(dir + "/" + entry->d_name, session);
+        }
+    }
+    closedir(dp);
+}
+
+size_t named_pipe::remove_stale() {
+    size_t removed = 0;
+    for_each_session([&removed](const std::string& path, long session) {
+        if (!process_alive(session_owner(session)) && unlink(path.c_str()) == 0) {
+            removed++;
+        }
+    });
+    return removed;
+}
+
+size_t named_pipe::live_sessions(pid_t except) {
+    size_t live = 0;
+    for_each_session([&live, except](const std::string&, long session) {
+        pid_t owner = session_owner(session);
+        if (owner != except && process_alive(owner)) {
+            live++;
+        }
+    });
+    return live;
+}
+
+std::unique_ptr<named_pipe> named_pipe::open_writer(const char* pipe_path) {
+    int fd = open(pipe_path, O_WRONLY | O_NONBLOCK);
+    if (fd == -1) {
+        return nullptr;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    return std::unique_ptr<named_pipe>(new named_pipe(fd, O_WRONLY));
+}
+
+named_pipe::named_pipe(int fd, int mode)
+    : pipe_fd(fd), open_mode(mode), peer_fd(-1), broken(false), codec(codec_type::none) { }
+
+named_pipe::named_pipe(const char* pipe_path, int mode)
+    : open_mode(mode), peer_fd(-1), broken(false), codec(codec_type::none) {
     pipe_fd = open(pipe_path, mode);
     if (pipe_fd == -1) {
         // TODO: Error handling
@@ -31,19 +101,146 @@ named_pipe::~named_pipe() {
     close(pipe_fd);
 }
 
-void named_pipe::pipe_from(FILE *fp) {
+void named_pipe::set_codec(codec_type type) {
+    codec = type;
+    comp.reset();
+    decomp.reset();
+    if (type != codec_type::none) {
+        if ((open_mode & O_ACCMODE) == O_WRONLY) {
+            comp.reset(new compressor(type));
+        } else {
+            decomp.reset(new decompressor(type));
+        }
+    }
+}
+
+bool named_pipe::write_all(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t res = write(pipe_fd, data, size);
+        if (res == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += res;
+        size -= res;
+    }
+    return true;
+}
+
+bool named_pipe::read_all(char* data, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        ssize_t res = read(pipe_fd, data + got, size - got);
+        if (res > 0) {
+            got += res;
+        } else if (res == -1 && errno == EAGAIN) {
+            pollfd pfds[2] = { { pipe_fd, POLLIN, 0 }, { peer_fd, POLLIN, 0 } };
+            poll(pfds, 2, -1);
+            if ((pfds[1].revents & POLLIN) && !(pfds[0].revents & POLLIN)) {
+                broken = true;
+                return false;
+            }
+        } else if (res == -1 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void named_pipe::reset() {
+    char buf[PIPE_BUFFER_SIZE];
+    int flags = fcntl(pipe_fd, F_GETFL);
+    fcntl(pipe_fd, F_SETFL, flags | O_NONBLOCK);
+    while (read(pipe_fd, buf, sizeof(buf)) > 0) { }
+    fcntl(pipe_fd, F_SETFL, flags);
+    broken = false;
+}
+
+bool named_pipe::write_data(const char* data, size_t size) {
+    while (size > 0) {
+        size_t chunk = size < PIPE_BUFFER_SIZE ? size : PIPE_BUFFER_SIZE;
+        frame_header_t header;
+        header.codec = (uint32_t)(comp ? comp->compress(data, chunk, frame) : codec_type::none);
+        header.raw_size = chunk;
+        const char* payload = data;
+        if (header.codec != (uint32_t)codec_type::none) {
+            payload = frame.data();
+            header.size = frame.size();
+        } else {
+            header.size = chunk;
+        }
+        if (!write_all((const char *)&header, sizeof(header)) || !write_all(payload, header.size)) {
+            return false;
+        }
+        DS_PROBE(pipe_write_frame, header.raw_size, header.size);
+        data += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool named_pipe::write_trailer(const std::string& text) {
+    frame_header_t header = { FRAME_TRAILER, (uint32_t)text.size(), (uint32_t)text.size() };
+    return text.empty() || (write_all((const char *)&header, sizeof(header)) && write_all(text.data(), text.size()));
+}
+
+bool named_pipe::finish() {
+    if (comp) {
+        comp->reset();
+    }
+    frame_header_t header = { (uint32_t)codec_type::none, 0, 0 };
+    return write_all((const char *)&header, sizeof(header));
+}
+
+bool named_pipe::pipe_from(FILE *fp) {
+    return pipe_from(fp, [this](const char* data, size_t size) {
+        return write_data(data, size);
+    });
+}
+
+bool named_pipe::pipe_from(FILE *fp, const std::function<bool (const char*, size_t)>& stage) {
     pip_buf_t buf;
     unsigned int read_size;
+    bool connected = true;
     while((read_size = fread(buf->data, sizeof(char), PIPE_BUFFER_SIZE, fp)) > 0) {
-        write(pipe_fd, buf->data, read_size);
+        if (connected && !stage(buf->data, read_size)) {
+            connected = false;
+        }
     }
+    return connected;
 }
 
-void named_pipe::pipe_to(FILE *fp) {
-    pip_buf_t buf;
-    int read_size;
-    while((read_size = read(pipe_fd, buf->data, PIPE_BUFFER_SIZE)) > 0) {
-        fwrite(buf->data, sizeof(char), read_size, fp);
+size_t named_pipe::pipe_to(FILE *fp) {
+    size_t total = 0;
+    frame_header_t header;
+    std::vector<char> payload;
+    if (decomp) {
+        decomp->reset();
     }
+    trailer_text.clear();
+    while (read_all((char *)&header, sizeof(header)) && header.raw_size > 0) {
+        payload.resize(header.size);
+        if (!read_all(payload.data(), header.size)) {
+            break;
+        }
+        DS_PROBE(pipe_read_frame, header.raw_size, header.size);
+        if (header.codec == FRAME_TRAILER) {
+            trailer_text.assign(payload.data(), header.size);
+        }
+        else if (header.codec == (uint32_t)codec_type::none) {
+            fwrite(payload.data(), sizeof(char), header.size, fp);
+            total += header.size;
+        } else if (decomp && decomp->decompress(payload.data(), header.size, header.raw_size, frame)) {
+            fwrite(frame.data(), sizeof(char), header.raw_size, fp);
+            total += header.raw_size;
+        } else {
+            fprintf(stderr, "pipe: corrupted frame\n");
+        }
+    }
+    fflush(fp);
+    return total;
 }
-
@@ -0,0 +1,148 @@
+#include "path_cache.hh"
+
+#include <set>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+extern char **environ;
+
+static const std::set<std::string> SHELL_WORDS = {
+    ".", ":", "alias", "bg", "break", "case", "cd", "command", "continue", "do", "done", "elif", "else",
+    "esac", "eval", "exec", "exit", "export", "fg", "fi", "for", "function", "getopts", "hash", "if",
+    "jobs", "local", "pwd", "read", "readonly", "return", "set", "shift", "source", "then", "times", "trap",
+    "type", "ulimit", "umask", "unalias", "unset", "until", "wait", "while"
+};
+
+bool path_cache::plain_words(const std::string& command, std::vector<std::string>& args) {
+    if (command.find_first_of("|&;<>()$`\\\"'*?[]#~={}!\t\n") != std::string::npos) {
+        return false;
+    }
+    args.clear();
+    std::string::size_type pos = 0;
+    while (pos < command.size()) {
+        std::string::size_type end = command.find(' ', pos);
+        if (end == std::string::npos) {
+            end = command.size();
+        }
+        if (end > pos) {
+            args.emplace_back(command, pos, end - pos);
+        }
+        pos = end + 1;
+    }
+    return !args.empty();
+}
+
+bool path_cache::simple_command(const std::string& command, std::vector<std::string>& args) {
+    return plain_words(command, args) && SHELL_WORDS.count(args.front()) == 0;
+}
+
+path_cache::path_cache(const char* path)
+    : hits(0), misses(0), probes(0), invalidations(0) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    std::string value = path ? path : "";
+    std::string::size_type pos = 0;
+    while (pos <= value.size()) {
+        std::string::size_type end = value.find(':', pos);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        dirs.push_back(end > pos ? value.substr(pos, end - pos) : ".");
+        watches.push_back(-1);
+        pos = end + 1;
+    }
+    watch();
+
+    for (char **e = environ; *e; e++) {
+        env_storage.emplace_back(*e);
+    }
+    for (auto& e : env_storage) {
+        env.push_back(e.data());
+    }
+    env.push_back(nullptr);
+}
+
+path_cache::~path_cache() {
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+    }
+}
+
+void path_cache::watch() {
+    if (inotify_fd == -1) {
+        return;
+    }
+    for (size_t i = 0; i < dirs.size(); i++) {
+        if (watches[i] == -1) {
+            watches[i] = inotify_add_watch(inotify_fd, dirs[i].c_str(),
+                                           IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB |
+                                           IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+        }
+    }
+}
+
+void path_cache::drain() {
+    if (inotify_fd == -1) {
+        entries.clear();
+        return;
+    }
+    alignas(inotify_event) char buf[4096];
+    ssize_t size;
+    while ((size = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + size; p += sizeof(inotify_event) + ((inotify_event *)p)->len) {
+            inotify_event *event = (inotify_event *)p;
+            invalidations++;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED | IN_Q_OVERFLOW)) {
+                entries.clear();
+                // the path no longer names the watched directory; watch it again once it does
+                if (event->mask & IN_MOVE_SELF) {
+                    inotify_rm_watch(inotify_fd, event->wd);
+                }
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                    for (auto& wd : watches) {
+                        if (wd == event->wd) {
+                            wd = -1;
+                        }
+                    }
+                }
+            } else if (event->len > 0) {
+                entries.erase(event->name);
+            }
+        }
+    }
+}
+
+std::string path_cache::resolve(const std::string& name) {
+    drain();
+    auto it = entries.find(name);
+    if (it != entries.end()) {
+        hits++;
+        return it->second;
+    }
+    misses++;
+    watch();
+    std::string found;
+    // a name can appear in an unwatched directory unnoticed
+    bool cacheable = true;
+    if (name.find('/') != std::string::npos) {
+        found = name;
+    } else {
+        for (size_t i = 0; i < dirs.size(); i++) {
+            std::string candidate = dirs[i] + "/" + name;
+            struct stat st;
+            probes++;
+            if (stat(candidate.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(candidate.c_str(), X_OK) == 0) {
+                found = candidate;
+                break;
+            }
+            cacheable = cacheable && watches[i] != -1;
+        }
+    }
+    if (!cacheable) {
+        return found;
+    }
+    return entries.emplace(name, found).first->second;
+}
@@ -0,0 +1,218 @@
+#include "path_translator.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+
+static std::string join(const std::string& dir, const std::string& name) {
+    return dir == "/" ? "/" + name : dir + "/" + name;
+}
+
+static std::string parent(const std::string& dir) {
+    std::string::size_type pos = dir.rfind('/');
+    return pos == 0 || pos == std::string::npos ? std::string("/") : dir.substr(0, pos);
+}
+
+path_translator::path_translator(const std::string& cwd)
+    : cwd(cwd), hits(0), loads(0), invalidations(0) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) {
+        perror("inotify_init1");
+    }
+}
+
+path_translator::~path_translator() {
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+    }
+}
+
+std::string path_translator::fold(std::string_view name) {
+    std::string res(name);
+    for (auto& c : res) {
+        c = std::tolower(static_cast<unsigned char>(c));
+    }
+    return res;
+}
+
+void path_translator::drop(const std::string& dir) {
+    for (auto it = dirs.begin(); it != dirs.end(); ) {
+        const std::string& path = it->first;
+        if (path != dir && !(path.compare(0, dir.size(), dir) == 0 && (dir == "/" || path[dir.size()] == '/'))) {
+            ++it;
+            continue;
+        }
+        int wd = it->second.wd;
+        auto range = watches.equal_range(wd);
+        for (auto w = range.first; w != range.second; ++w) {
+            if (w->second == path) {
+                watches.erase(w);
+                break;
+            }
+        }
+        if (watches.count(wd) == 0) {
+            inotify_rm_watch(inotify_fd, wd);
+        }
+        it = dirs.erase(it);
+    }
+}
+
+void path_translator::drop_all() {
+    for (auto& dir : dirs) {
+        inotify_rm_watch(inotify_fd, dir.second.wd);
+    }
+    dirs.clear();
+    watches.clear();
+}
+
+void path_translator::drain() {
+    if (inotify_fd == -1) {
+        return;
+    }
+    alignas(inotify_event) char buf[4096];
+    ssize_t size;
+    while ((size = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + size; p += sizeof(inotify_event) + ((inotify_event *)p)->len) {
+            inotify_event *event = (inotify_event *)p;
+            invalidations++;
+            if (event->mask & IN_Q_OVERFLOW) {
+                drop_all();
+                continue;
+            }
+            std::vector<std::string> affected;
+            auto range = watches.equal_range(event->wd);
+            for (auto w = range.first; w != range.second; ++w) {
+                affected.push_back(w->second);
+            }
+            for (auto& dir : affected) {
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                    drop(dir);
+                    continue;
+                }
+                auto it = dirs.find(dir);
+                if (it == dirs.end() || event->len == 0) {
+                    continue;
+                }
+                std::string name(event->name);
+                std::vector<std::string>& names = it->second.entries[fold(name)];
+                auto found = std::find(names.begin(), names.end(), name);
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    if (found == names.end()) {
+                        names.push_back(name);
+                    }
+                }
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    if (found != names.end()) {
+                        names.erase(found);
+                    }
+                    if (names.empty()) {
+                        it->second.entries.erase(fold(name));
+                    }
+                    if (event->mask & IN_ISDIR) {
+                        drop(join(dir, name));
+                    }
+                }
+            }
+        }
+    }
+}
+
+path_translator::directory_t* path_translator::load(const std::string& dir) {
+    if (dirs.size() >= PATH_TRANSLATOR_MAX_DIRS) {
+        drop_all();
+    }
+    int wd = inotify_fd == -1 ? -1 :
+        inotify_add_watch(inotify_fd, dir.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                                   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+    DIR *dp = opendir(dir.c_str());
+    if (!dp) {
+        if (wd != -1 && watches.count(wd) == 0) {
+            inotify_rm_watch(inotify_fd, wd);
+        }
+        return nullptr;
+    }
+    loads++;
+    directory_t loaded;
+    loaded.wd = wd;
+    while (dirent *entry = readdir(dp)) {
+        std::string name(entry->d_name);
+        if (name != "." && name != "..") {
+            loaded.entries[fold(name)].push_back(name);
+        }
+    }
+    closedir(dp);
+    // without a watch the listing could go stale, so use it once only
+    if (wd == -1) {
+        scratch = std::move(loaded);
+        return &scratch;
+    }
+    watches.emplace(wd, dir);
+    return &(dirs[dir] = std::move(loaded));
+}
+
+std::string path_translator::lookup(const std::string& dir, const std::string& name) {
+    directory_t *d;
+    auto it = dirs.find(dir);
+    if (it != dirs.end()) {
+        hits++;
+        d = &it->second;
+    }
+    else if (!(d = load(dir))) {
+        return std::string();
+    }
+    auto entry = d->entries.find(fold(name));
+    if (entry == d->entries.end()) {
+        return std::string();
+    }
+    for (auto& real : entry->second) {
+        if (real == name) {
+            return real;
+        }
+    }
+    return entry->second.front();
+}
+
+std::string path_translator::translate(std::string_view path) {
+    std::string res(path);
+    std::replace(res.begin(), res.end(), '\\', '/');
+    if (res.size() >= 2 && std::isalpha(static_cast<unsigned char>(res[0])) && res[1] == ':') {
+        if (res.size() == 2 || res[2] == '/') {
+            std::string root(PATH_DRIVE_ROOT);
+            while (!root.empty() && root.back() == '/') {
+                root.pop_back();
+            }
+            res = root + (res.size() == 2 ? std::string("/") : res.substr(2));
+        }
+        else {
+            res.erase(0, 2);
+        }
+    }
+
+    drain();
+    std::string dir = !res.empty() && res[0] == '/' ? std::string("/") : cwd;
+    std::string::size_type pos = 0;
+    while (pos < res.size()) {
+        std::string::size_type end = res.find('/', pos);
+        if (end == std::string::npos) {
+            end = res.size();
+        }
+        std::string name = res.substr(pos, end - pos);
+        if (name == "..") {
+            dir = parent(dir);
+        }
+        else if (!name.empty() && name != ".") {
+            std::string real = lookup(dir, name);
+            // the rest does not exist (yet); leave it as typed
+            if (real.empty()) {
+                break;
+            }
+            res.replace(pos, name.size(), real);
+            end = pos + real.size();
+            dir = join(dir, real);
+        }
+        pos = end + 1;
+    }
+    return res;
+}
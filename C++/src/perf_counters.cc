@@ -0,0 +1,129 @@
+#include "perf_counters.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+enum class event_state {
+    unknown,
+    full,
+    user_only,
+    unavailable
+};
+
+struct event_t {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+    // meaningless when the kernel side is excluded
+    bool needs_kernel;
+};
+
+static const event_t EVENTS[] = {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false },
+    { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, true },
+    { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, false },
+    { "task-clock-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, false },
+};
+constexpr const size_t EVENT_COUNT = sizeof(EVENTS) / sizeof(EVENTS[0]);
+
+// learned on first use so unsupported events cost nothing afterwards
+static event_state states[EVENT_COUNT];
+
+static int open_event(const event_t& event, pid_t pid, bool user_only) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    // also counts the threads and children started while it is open, e.g.
+    // the dir_lister and file_ops workers
+    attr.inherit = 1;
+    attr.exclude_kernel = user_only;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+perf_counters::perf_counters() {
+    open_all(0);
+}
+
+perf_counters::~perf_counters() {
+    for (auto& c : counters) {
+        close(c.fd);
+    }
+}
+
+void perf_counters::attach(pid_t pid) {
+    open_all(pid);
+}
+
+void perf_counters::open_all(pid_t pid) {
+    for (size_t i = 0; i < EVENT_COUNT; i++) {
+        if (states[i] == event_state::unavailable) {
+            continue;
+        }
+        int fd = -1;
+        if (states[i] != event_state::user_only) {
+            fd = open_event(EVENTS[i], pid, false);
+            if (fd != -1) {
+                states[i] = event_state::full;
+            }
+            else if (errno != EACCES && errno != EPERM) {
+                if (errno != ESRCH) {
+                    states[i] = event_state::unavailable;
+                }
+                continue;
+            }
+            else if (EVENTS[i].needs_kernel) {
+                states[i] = event_state::unavailable;
+                continue;
+            }
+        }
+        if (fd == -1) {
+            fd = open_event(EVENTS[i], pid, true);
+            if (fd != -1) {
+                states[i] = event_state::user_only;
+            }
+            else if (errno != ESRCH) {
+                states[i] = event_state::unavailable;
+            }
+        }
+        if (fd != -1) {
+            counters.push_back({ i, fd, pid != 0 });
+        }
+    }
+}
+
+std::string perf_counters::report() const {
+    std::string backend = report(false);
+    std::string executor = report(true);
+    std::string res = backend.empty() ? std::string() : "backend:" + backend;
+    if (!executor.empty()) {
+        res += (res.empty() ? "" : " ") + std::string("executor:") + executor;
+    }
+    return res;
+}
+
+std::string perf_counters::report(bool attached) const {
+    std::string res;
+    for (size_t i = 0; i < EVENT_COUNT; i++) {
+        bool counted = false;
+        uint64_t total = 0;
+        for (auto& c : counters) {
+            uint64_t value;
+            if (c.event == i && c.attached == attached && read(c.fd, &value, sizeof(value)) == sizeof(value)) {
+                total += value;
+                counted = true;
+            }
+        }
+        if (counted) {
+            res += " " + std::string(EVENTS[i].name) + "=" + std::to_string(total);
+        }
+    }
+    return res;
+}
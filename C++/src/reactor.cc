@@ -0,0 +1,139 @@
+#include "reactor.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+reactor::reactor() : pending(0) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd == -1 || wake_fd == -1) {
+        // TODO: Error handling
+        perror("reactor");
+        exit(EXIT_FAILURE);
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+}
+
+reactor::~reactor() {
+    close(wake_fd);
+    close(epoll_fd);
+}
+
+reactor::detached reactor::launch(reactor* r, task<void> t) {
+    co_await r->schedule();
+    co_await t;
+    if (r->pending.fetch_sub(1) == 1) {
+        r->wake();
+    }
+}
+
+void reactor::spawn(task<void> t) {
+    pending.fetch_add(1);
+    launch(this, std::move(t));
+}
+
+void reactor::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(handle);
+    }
+    wake();
+}
+
+void reactor::wake() {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        perror("reactor wake");
+    }
+}
+
+void reactor::watch(int fd, std::coroutine_handle<> handle) {
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.ptr = handle.address();
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+        if (errno != ENOENT || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            // not pollable: let the caller retry its operation
+            post(handle);
+        }
+    }
+}
+
+bool reactor::resume_ready() {
+    std::coroutine_handle<> handle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ready.empty()) {
+            return false;
+        }
+        handle = ready.front();
+        ready.pop_front();
+    }
+    handle.resume();
+    return true;
+}
+
+void reactor::poll(int timeout_ms) {
+    epoll_event events[64];
+    int n = epoll_wait(epoll_fd, events, 64, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.ptr == nullptr) {
+            // stays signalled once everything finished so that every runner wakes up
+            if (pending.load() > 0) {
+                uint64_t value;
+                if (read(wake_fd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+                    perror("reactor wake");
+                }
+            }
+            continue;
+        }
+        std::coroutine_handle<>::from_address(events[i].data.ptr).resume();
+    }
+}
+
+void reactor::run() {
+    while (pending.load() > 0) {
+        if (!resume_ready()) {
+            poll(-1);
+        }
+    }
+}
+
+byte_stream::byte_stream(reactor& r, int fd) : r(r), fd(fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+byte_stream::~byte_stream() {
+    close(fd);
+}
+
+task<size_t> byte_stream::read(char* data, size_t size) {
+    while (true) {
+        ssize_t res = ::read(fd, data, size);
+        if (res >= 0) {
+            co_return res;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN) {
+            co_return 0;
+        }
+        co_await r.readable(fd);
+    }
+}
+
+task<std::string> byte_stream::read_some() {
+    std::string chunk(PIPE_BUFFER_SIZE, '\0');
+    size_t size = co_await read(chunk.data(), chunk.size());
+    chunk.resize(size);
+    co_return chunk;
+}
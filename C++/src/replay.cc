@@ -0,0 +1,196 @@
+#include "definations.hh"
+#include "message_queue.hh"
+#include "heavy_slots.hh"
+#include "named_pipe.hh"
+#include "trace.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+using replay_clock = std::chrono::steady_clock;
+
+typedef struct _replay_result {
+    uint64_t latency_us;
+    uint64_t lateness_us;
+    uint64_t output_size;
+} replay_result_t;
+
+void replay(const char* trace_path, double speed, unsigned int concurrency, bool verbose);
+void replay_worker(message_queue& msq, long session, const std::vector<trace_record_t>& records,
+                   std::atomic<size_t>& next, replay_clock::time_point start, double speed,
+                   std::vector<replay_result_t>& results);
+void report(const std::vector<replay_result_t>& results, double seconds);
+
+int main(int argc, char *argv[]) {
+    int ch;
+    bool verbose = false;
+    const char* trace_path = nullptr;
+    double speed = 1.0;
+    unsigned int concurrency = 1;
+    while ((ch = getopt(argc, argv, "vf:s:c:")) != -1) {
+        switch (ch) {
+        case 'v':
+            verbose = true;
+            break;
+        case 'f':
+            trace_path = optarg;
+            break;
+        case 's':
+            speed = std::stod(optarg);
+            break;
+        case 'c':
+            concurrency = std::max(1, std::stoi(optarg));
+            if (concurrency > REPLAY_MAX_CONCURRENCY) {
+                std::cout << "Concurrency is limited to " << REPLAY_MAX_CONCURRENCY << " sessions" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            break;
+        default:
+            std::cout << "Unknown argument: " << ch << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!trace_path) {
+        std::cout << "Usage: " << argv[0] << " -f trace [-s speed (0 = max)] [-c concurrency] [-v]" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    replay(trace_path, speed, concurrency, verbose);
+    return 0;
+}
+
+void replay(const char* trace_path, double speed, unsigned int concurrency, bool verbose) {
+    std::vector<trace_record_t> records;
+    {
+        trace_reader reader(trace_path);
+        trace_record_t record;
+        while (reader.read(record)) {
+            records.push_back(record);
+        }
+    }
+    if (verbose) {
+        std::cout << "[RP] Loaded " << records.size() << " requests from '" << trace_path << "'" << std::endl;
+    }
+
+    std::vector<long> sessions;
+    for (unsigned int i = 0; i < concurrency; i++) {
+        sessions.push_back(replay_session(getpid(), i));
+        named_pipe::make_pipe(named_pipe::session_path(sessions.back()).c_str());
+    }
+
+    // joined before the backend starts, so created() tells whether it is ours
+    message_queue msq(MESSAGE_QUEUE_KEY);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    else if (pid == 0) {
+        execl(BACKEND_PATH, BACKEND_NAME, NULL);
+        perror("exec backend");
+        exit(EXIT_FAILURE);
+    }
+
+    msq.receive(MESSAGE_TYPE_READY);
+    if (verbose) {
+        std::cout << "[RP] Backend ready. Replaying with " << concurrency << " sessions at "
+                  << (speed > 0 ? std::to_string(speed) + "x" : std::string("max")) << " speed..." << std::endl;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::vector<replay_result_t>> results(concurrency);
+    std::vector<std::thread> workers;
+    auto start = replay_clock::now();
+    for (unsigned int i = 0; i < concurrency; i++) {
+        workers.emplace_back(replay_worker, std::ref(msq), sessions[i], std::cref(records),
+                             std::ref(next), start, speed, std::ref(results[i]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(replay_clock::now() - start).count();
+
+    // stop our own backend; repeat the signal in case it landed just
+    // before a blocking receive
+    int stat;
+    do {
+        kill(pid, SIGTERM);
+        std::this_thread::sleep_for(std::chrono::milliseconds(SUPERVISOR_POLL_MS));
+    } while (waitpid(pid, &stat, WNOHANG) == 0);
+    for (long session : sessions) {
+        unlink(named_pipe::session_path(session).c_str());
+    }
+    if (msq.created() && named_pipe::live_sessions(getpid()) == 0) {
+        msq.destroy();
+        heavy_slots(SCHEDULER_HEAVY_KEY).destroy();
+    }
+
+    std::vector<replay_result_t> merged;
+    for (auto& part : results) {
+        merged.insert(merged.end(), part.begin(), part.end());
+    }
+    report(merged, seconds);
+}
+
+void replay_worker(message_queue& msq, long session, const std::vector<trace_record_t>& records,
+                   std::atomic<size_t>& next, replay_clock::time_point start, double speed,
+                   std::vector<replay_result_t>& results) {
+    named_pipe np(named_pipe::session_path(session).c_str(), O_RDWR | O_NONBLOCK);
+    FILE *sink = fopen("/dev/null", "w");
+
+    size_t index;
+    while ((index = next.fetch_add(1)) < records.size()) {
+        const trace_record_t& record = records[index];
+        auto scheduled = start;
+        if (speed > 0) {
+            scheduled += std::chrono::microseconds((uint64_t)(record.offset_us / speed));
+            std::this_thread::sleep_until(scheduled);
+        }
+
+        auto request_start = replay_clock::now();
+        msq.send(session_request_type(session), record.command, session);
+        replay_result_t result;
+        result.output_size = np.pipe_to(sink);
+        msq.receive(session_response_type(session));
+        auto request_end = replay_clock::now();
+
+        result.latency_us = std::chrono::duration_cast<std::chrono::microseconds>(request_end - request_start).count();
+        result.lateness_us = std::chrono::duration_cast<std::chrono::microseconds>(request_start - scheduled).count();
+        results.push_back(result);
+    }
+    fclose(sink);
+}
+
+void report(const std::vector<replay_result_t>& results, double seconds) {
+    if (results.empty()) {
+        std::cout << "No requests replayed." << std::endl;
+        return;
+    }
+    std::vector<uint64_t> latencies;
+    uint64_t bytes = 0;
+    uint64_t max_lateness = 0;
+    for (const auto& result : results) {
+        latencies.push_back(result.latency_us);
+        bytes += result.output_size;
+        max_lateness = std::max(max_lateness, result.lateness_us);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, (size_t)(latencies.size() * p))];
+    };
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "requests:   " << results.size() << " in " << seconds << " s ("
+              << results.size() / seconds << " req/s, " << bytes / seconds / 1024 << " KiB/s output)" << std::endl
+              << "latency us: p50 " << percentile(0.5) << "  p90 " << percentile(0.9)
+              << "  p99 " << percentile(0.99) << "  max " << latencies.back() << std::endl
+              << "max start lateness: " << max_lateness << " us" << std::endl;
+}
@@ -0,0 +1,236 @@
+#include "scheduler.hh"
+
+#include <algorithm>
+#include <vector>
+
+_sched_stats::_sched_stats()
+    : dispatched(0), total_wait_us(0), max_wait_us(0), histogram{ 0 } { }
+
+void _sched_stats::record(unsigned long long wait_us) {
+    unsigned int bucket = 0;
+    while (bucket + 1 < HISTOGRAM_BUCKETS && (1ULL << bucket) <= wait_us) {
+        bucket++;
+    }
+    histogram[bucket]++;
+    dispatched++;
+    total_wait_us += wait_us;
+    max_wait_us = std::max(max_wait_us, wait_us);
+}
+
+unsigned long long _sched_stats::percentile(double p) const {
+    unsigned long target = (unsigned long)(dispatched * p);
+    unsigned long seen = 0;
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > target) {
+            return 1ULL << i;
+        }
+    }
+    return max_wait_us;
+}
+
+// true if a whole option word before "--" sets one of `flags`, alone or
+// bundled (-rf), or spells out `name`
+static bool has_option(const std::vector<std::string>& words, const std::string& flags, const char* name) {
+    for (const auto& word : words) {
+        if (word == "--") {
+            break;
+        }
+        if (word == name) {
+            return true;
+        }
+        if (word.size() > 1 && word[0] == '-' && word[1] != '-' && word.find_first_of(flags) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+priority_class scheduler::classify(const std::string& command, bool& heavy) {
+    std::vector<std::string> words;
+    std::string::size_type pos = 0;
+    while (pos < command.size()) {
+        std::string::size_type end = command.find(' ', pos);
+        if (end == std::string::npos) {
+            end = command.size();
+        }
+        if (end > pos) {
+            words.push_back(command.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    std::string program = words.empty() ? std::string() : words[0];
+
+    if (program == "rm" || program == "mv" || program == "cp" || program == "find") {
+        heavy = program == "find" || has_option(words, "rR", "--recursive")
+            || command.find_first_of("*?") != std::string::npos;
+        return priority_class::batch;
+    }
+    if (program == "ls" && has_option(words, "R", "--recursive")) {
+        heavy = true;
+        return priority_class::batch;
+    }
+    heavy = false;
+    return priority_class::interactive;
+}
+
+scheduler::scheduler(unsigned int quantum, unsigned int max_heavy, heavy_slots* shared)
+    : quantum(std::max(quantum, SCHEDULER_BATCH_COST)), max_heavy(max_heavy), running_heavy(0), shared(shared) { }
+
+void scheduler::push(long session, std::string command, sched_clock::time_point sent) {
+    sched_request_t req;
+    req.session = session;
+    req.priority = classify(command, req.heavy);
+    req.command = std::move(command);
+    req.enqueued = sent;
+
+    class_queue& cq = classes[(int)req.priority];
+    session_queue& sq = cq.sessions[session];
+    if (sq.pending.empty()) {
+        cq.active.push_back(session);
+    }
+    sq.pending.push_back(std::move(req));
+    cq.depth++;
+}
+
+bool scheduler::take_heavy_slot() {
+    return running_heavy < max_heavy && (!shared || shared->try_acquire());
+}
+
+void scheduler::release_heavy_slot() {
+    if (shared) {
+        shared->release();
+    }
+}
+
+bool scheduler::runnable(const class_queue& cq, bool heavy_slot) const {
+    for (const auto& entry : cq.sessions) {
+        if (!entry.second.pending.front().heavy || heavy_slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool scheduler::oldest_waited(const class_queue& cq, sched_clock::time_point now, unsigned int limit_ms) const {
+    for (const auto& entry : cq.sessions) {
+        if (now - entry.second.pending.front().enqueued >= std::chrono::milliseconds(limit_ms)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool scheduler::dispatch(class_queue& cq, sched_request_t& req) {
+    // taken up front so the session walk below cannot spin on a slot
+    // another backend grabs meanwhile; given back if no heavy request runs
+    bool heavy_head = false;
+    for (const auto& entry : cq.sessions) {
+        heavy_head = heavy_head || entry.second.pending.front().heavy;
+    }
+    bool heavy_slot = heavy_head && take_heavy_slot();
+    if (!runnable(cq, heavy_slot)) {
+        if (heavy_slot) {
+            release_heavy_slot();
+        }
+        return false;
+    }
+    while (true) {
+        long session = cq.active.front();
+        session_queue& sq = cq.sessions[session];
+        const sched_request_t& head = sq.pending.front();
+        unsigned int cost = head.priority == priority_class::batch ? SCHEDULER_BATCH_COST : 1;
+
+        if (head.heavy && !heavy_slot) {
+            cq.active.pop_front();
+            cq.active.push_back(session);
+            continue;
+        }
+        if (sq.deficit < cost) {
+            sq.deficit += quantum;
+            cq.active.pop_front();
+            cq.active.push_back(session);
+            continue;
+        }
+
+        sq.deficit -= cost;
+        req = std::move(sq.pending.front());
+        sq.pending.pop_front();
+        cq.depth--;
+        if (sq.pending.empty()) {
+            cq.sessions.erase(session);
+            cq.active.pop_front();
+        }
+        if (req.heavy) {
+            running_heavy++;
+        }
+        else if (heavy_slot) {
+            release_heavy_slot();
+        }
+
+        auto wait = sched_clock::now() - req.enqueued;
+        cq.stats.record(std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+        return true;
+    }
+}
+
+bool scheduler::next(sched_request_t& req) {
+    class_queue& interactive = classes[(int)priority_class::interactive];
+    class_queue& batch = classes[(int)priority_class::batch];
+
+    if (batch.depth > 0 && oldest_waited(batch, sched_clock::now(), SCHEDULER_BATCH_MAX_WAIT_MS)) {
+        if (dispatch(batch, req)) {
+            return true;
+        }
+    }
+    return dispatch(interactive, req) || dispatch(batch, req);
+}
+
+void scheduler::finish(const sched_request_t& req) {
+    if (req.heavy && running_heavy > 0) {
+        running_heavy--;
+        release_heavy_slot();
+    }
+}
+
+std::vector<sched_request_t> scheduler::drain() {
+    std::vector<sched_request_t> drained;
+    for (auto& cq : classes) {
+        for (long session : cq.active) {
+            for (auto& req : cq.sessions[session].pending) {
+                drained.push_back(std::move(req));
+            }
+        }
+        cq.sessions.clear();
+        cq.active.clear();
+        cq.depth = 0;
+    }
+    return drained;
+}
+
+bool scheduler::empty() const {
+    return classes[0].depth == 0 && classes[1].depth == 0;
+}
+
+size_t scheduler::depth(priority_class priority) const {
+    return classes[(int)priority].depth;
+}
+
+const sched_stats_t& scheduler::stats(priority_class priority) const {
+    return classes[(int)priority].stats;
+}
+
+void scheduler::report(std::ostream& os) const {
+    const char* names[] = { "interactive", "batch" };
+    for (int i = 0; i < 2; i++) {
+        const sched_stats_t& st = classes[i].stats;
+        os << names[i] << ": depth=" << classes[i].depth
+           << " dispatched=" << st.dispatched
+           << " wait_avg=" << (st.dispatched ? st.total_wait_us / st.dispatched : 0) << "us"
+           << " wait_p50<=" << st.percentile(0.5) << "us"
+           << " wait_p99<=" << st.percentile(0.99) << "us"
+           << " wait_max=" << st.max_wait_us << "us" << std::endl;
+    }
+    os << "heavy running: " << running_heavy << "/" << max_heavy
+       << (shared ? " (cap shared with other backends)" : "") << std::endl;
+}
@@ -0,0 +1,143 @@
+#include "supervisor.hh"
+#include "message_queue.hh"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+supervisor::supervisor(transport& msq, long session, bool verbose)
+    : msq(msq), session(session), verbose(verbose), pid(-1), pid_fd(-1), failures(0), stopping(false) { }
+
+supervisor::~supervisor() {
+    if (pid != -1) {
+        stopping = true;
+        kill(pid, SIGTERM);
+        reap();
+    }
+}
+
+bool supervisor::spawn() {
+    pid_t parent = getpid();
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        pid = -1;
+        return false;
+    }
+    else if (pid == 0) {
+        // do not outlive a crashed frontend
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != parent) {
+            _exit(EXIT_FAILURE);
+        }
+        if (verbose) {
+            execl(BACKEND_PATH, BACKEND_NAME, "-v", NULL);
+        }
+        else {
+            execl(BACKEND_PATH, BACKEND_NAME, NULL);
+        }
+        perror("exec backend");
+        _exit(EXIT_FAILURE);
+    }
+    pid_fd = syscall(SYS_pidfd_open, pid, 0);
+    if (pid_fd == -1) {
+        perror("pidfd_open");
+    }
+    stopping = false;
+    watcher = std::thread(&supervisor::watch, this);
+    return true;
+}
+
+void supervisor::watch() {
+    if (pid_fd == -1) {
+        return;
+    }
+    pollfd pfd = { pid_fd, POLLIN, 0 };
+    while (poll(&pfd, 1, -1) == -1 && errno == EINTR) { }
+    if (!stopping) {
+        msq.send(session_response_type(session), SUPERVISOR_LOST_MESSAGE, session);
+    }
+}
+
+void supervisor::reap() {
+    if (pid != -1) {
+        int stat;
+        while (waitpid(pid, &stat, 0) == -1 && errno == EINTR) { }
+        if (verbose && !stopping) {
+            std::cout << "[FE] Backend " << pid << " exited with status " << stat << std::endl;
+        }
+        pid = -1;
+    }
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+    if (pid_fd != -1) {
+        close(pid_fd);
+        pid_fd = -1;
+    }
+}
+
+bool supervisor::start() {
+    while (true) {
+        if (spawn()) {
+            if (pid_fd == -1) {
+                msq.receive(MESSAGE_TYPE_READY);
+                return true;
+            }
+            pollfd pfd = { pid_fd, POLLIN, 0 };
+            while (true) {
+                long type;
+                std::tie(type, std::ignore, std::ignore, std::ignore) = msq.receive_session(MESSAGE_TYPE_READY, false);
+                if (type != 0) {
+                    return true;
+                }
+                if (poll(&pfd, 1, SUPERVISOR_POLL_MS) > 0) {
+                    break;
+                }
+            }
+            reap();
+        }
+        if (++failures > SUPERVISOR_MAX_RESTARTS) {
+            return false;
+        }
+        unsigned int backoff = std::min(SUPERVISOR_BACKOFF_MIN_MS << (failures - 1), SUPERVISOR_BACKOFF_MAX_MS);
+        if (verbose) {
+            std::cout << "[FE] Backend failed to start. Retrying in " << backoff << " ms..." << std::endl;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+    }
+}
+
+bool supervisor::restart() {
+    reap();
+    if (++failures > SUPERVISOR_MAX_RESTARTS) {
+        return false;
+    }
+    unsigned int backoff = std::min(SUPERVISOR_BACKOFF_MIN_MS << (failures - 1), SUPERVISOR_BACKOFF_MAX_MS);
+    if (verbose) {
+        std::cout << "[FE] Restarting backend in " << backoff << " ms..." << std::endl;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+    return start();
+}
+
+void supervisor::stop() {
+    stopping = true;
+    if (pid != -1) {
+        // the backend checks for the signal between commands; repeat it in
+        // case it landed just before a blocking receive
+        kill(pid, SIGTERM);
+        pollfd pfd = { pid_fd, POLLIN, 0 };
+        while (pid_fd != -1 && poll(&pfd, 1, SUPERVISOR_POLL_MS) == 0) {
+            kill(pid, SIGTERM);
+        }
+    }
+    reap();
+}
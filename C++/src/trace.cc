@@ -0,0 +1,87 @@
+#include "trace.hh"
+
+#include <stdlib.h>
+#include <string.h>
+
+trace_writer::trace_writer(const char* path) : last_offset(0) {
+    fp = fopen(path, "wb");
+    if (!fp) {
+        // TODO: Error handling
+        perror("open trace");
+        exit(EXIT_FAILURE);
+    }
+    fwrite(TRACE_MAGIC, sizeof(char), sizeof(TRACE_MAGIC) - 1, fp);
+    fputc(TRACE_VERSION, fp);
+}
+
+trace_writer::~trace_writer() {
+    fclose(fp);
+}
+
+void trace_writer::put_varint(uint64_t value) {
+    while (value >= 0x80) {
+        fputc((int)(value & 0x7f) | 0x80, fp);
+        value >>= 7;
+    }
+    fputc((int)value, fp);
+}
+
+void trace_writer::write(const trace_record_t& record) {
+    put_varint(record.offset_us - last_offset);
+    put_varint(record.latency_us);
+    put_varint(record.output_size);
+    put_varint(record.command.size());
+    fwrite(record.command.data(), sizeof(char), record.command.size(), fp);
+    fflush(fp);
+    last_offset = record.offset_us;
+}
+
+trace_reader::trace_reader(const char* path) : last_offset(0) {
+    fp = fopen(path, "rb");
+    if (!fp) {
+        // TODO: Error handling
+        perror("open trace");
+        exit(EXIT_FAILURE);
+    }
+    char magic[sizeof(TRACE_MAGIC)] = { 0 };
+    if (fread(magic, sizeof(char), sizeof(TRACE_MAGIC) - 1, fp) != sizeof(TRACE_MAGIC) - 1
+        || strcmp(magic, TRACE_MAGIC) != 0 || fgetc(fp) != TRACE_VERSION) {
+        fprintf(stderr, "open trace: %s is not a version %d trace\n", path, TRACE_VERSION);
+        exit(EXIT_FAILURE);
+    }
+}
+
+trace_reader::~trace_reader() {
+    fclose(fp);
+}
+
+bool trace_reader::get_varint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(fp);
+        if (c == EOF) {
+            return false;
+        }
+        value |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool trace_reader::read(trace_record_t& record) {
+    uint64_t delta;
+    uint64_t size;
+    if (!get_varint(delta) || !get_varint(record.latency_us)
+        || !get_varint(record.output_size) || !get_varint(size)) {
+        return false;
+    }
+    record.command.resize(size);
+    if (fread(&record.command[0], sizeof(char), size, fp) != size) {
+        return false;
+    }
+    last_offset += delta;
+    record.offset_us = last_offset;
+    return true;
+}
@@ -0,0 +1,110 @@
+#include "uring.hh"
+
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+uring::uring(unsigned int entries)
+    : ring_fd(-1), sq_ring(MAP_FAILED), cq_ring(MAP_FAILED), sqes((io_uring_sqe *)MAP_FAILED),
+      entries(0), cq_entries(0), pending(0) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd == -1) {
+        return;
+    }
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd, IORING_OFF_SQ_RING);
+    cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd, IORING_OFF_CQ_RING);
+    sqes = (io_uring_sqe *)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                ring_fd, IORING_OFF_SQES);
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+        close(ring_fd);
+        ring_fd = -1;
+        return;
+    }
+
+    char* sq = (char *)sq_ring;
+    sq_head = (unsigned *)(sq + params.sq_off.head);
+    sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    sq_array = (unsigned *)(sq + params.sq_off.array);
+    char* cq = (char *)cq_ring;
+    cq_head = (unsigned *)(cq + params.cq_off.head);
+    cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+    this->entries = params.sq_entries;
+    cq_entries = params.cq_entries;
+}
+
+uring::~uring() {
+    if (sqes != MAP_FAILED) {
+        munmap(sqes, sqes_size);
+    }
+    if (cq_ring != MAP_FAILED) {
+        munmap(cq_ring, cq_ring_size);
+    }
+    if (sq_ring != MAP_FAILED) {
+        munmap(sq_ring, sq_ring_size);
+    }
+    if (ring_fd != -1) {
+        close(ring_fd);
+    }
+}
+
+bool uring::supports(unsigned char opcode) {
+    constexpr const unsigned int PROBE_OPS = 256;
+    std::vector<char> buf(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = (io_uring_probe *)buf.data();
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0) {
+        return false;
+    }
+    return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+}
+
+io_uring_sqe* uring::get_sqe() {
+    unsigned tail = *sq_tail + pending;
+    if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= entries) {
+        return nullptr;
+    }
+    unsigned index = tail & *sq_mask;
+    sq_array[index] = index;
+    pending++;
+    std::memset(&sqes[index], 0, sizeof(io_uring_sqe));
+    return &sqes[index];
+}
+
+int uring::submit(unsigned int wait_nr) {
+    __atomic_store_n(sq_tail, *sq_tail + pending, __ATOMIC_RELEASE);
+    pending = 0;
+    // includes entries a short submit left in the ring
+    unsigned int count = *sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    int flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    return syscall(__NR_io_uring_enter, ring_fd, count, wait_nr, flags, nullptr, 0);
+}
+
+unsigned int uring::cancel_unsubmitted() {
+    unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    unsigned int count = *sq_tail - head + pending;
+    __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+    pending = 0;
+    return count;
+}
+
+bool uring::peek(io_uring_cqe& cqe) {
+    unsigned head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    cqe = cqes[head & *cq_mask];
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
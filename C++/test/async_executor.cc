@@ -0,0 +1,57 @@
+#include "async_executor.hh"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cerrno>
+#include <sys/wait.h>
+
+static size_t failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << what << std::endl;
+        failures++;
+    }
+}
+
+static task<void> run_commands(async_executor& executor) {
+    command_result_t result = co_await executor.run("echo hello; echo world");
+    expect(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 0, "echo did not exit cleanly");
+    expect(result.output == "hello\nworld\n", "unexpected output '" + result.output + "'");
+
+    result = co_await executor.run("exit 3");
+    expect(WIFEXITED(result.status) && WEXITSTATUS(result.status) == 3, "exit status not passed through");
+
+    result = co_await executor.run("head -c 200000 /dev/zero");
+    expect(result.output.size() == 200000, "large output truncated to " + std::to_string(result.output.size()));
+}
+
+// dropping a process before wait() must neither block the reactor nor leak the child
+static task<void> abandon(async_executor& executor, std::chrono::steady_clock::duration& blocked) {
+    auto process = executor.spawn("sleep 30");
+    expect(process != nullptr, "spawn failed");
+    auto start = std::chrono::steady_clock::now();
+    process.reset();
+    blocked = std::chrono::steady_clock::now() - start;
+    co_return;
+}
+
+int main() {
+    reactor r;
+    async_executor executor(r);
+    std::chrono::steady_clock::duration blocked{};
+    r.spawn(run_commands(executor));
+    r.spawn(abandon(executor, blocked));
+
+    auto start = std::chrono::steady_clock::now();
+    r.run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    expect(blocked < std::chrono::milliseconds(100), "destroying a running process blocked the reactor");
+    expect(elapsed < std::chrono::seconds(10), "abandoned process was waited for instead of killed");
+    expect(waitpid(-1, nullptr, WNOHANG) == -1 && errno == ECHILD, "abandoned process was not reaped");
+
+    std::cout << "async executor commands and abandoned processes: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
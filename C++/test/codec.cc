@@ -0,0 +1,129 @@
+#include "codec.hh"
+#include "named_pipe.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+
+static const std::string PIPE_PATH = "/tmp/lcc_test_codec";
+
+static size_t failures = 0;
+
+static std::string make_listing(size_t size, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::string res;
+    while (res.size() < size) {
+        res += "-rw-r--r-- 1 user user " + std::to_string(rng() % 100000) + " 2024-01-10 src/file_"
+            + std::to_string(rng() % 1000) + ".cc\n";
+    }
+    res.resize(size);
+    return res;
+}
+
+static std::string make_random(size_t size, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::string res(size, '\0');
+    for (auto& c : res) {
+        c = (char)rng();
+    }
+    return res;
+}
+
+static void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << what << std::endl;
+        failures++;
+    }
+}
+
+// frames of one command, with incompressible stretches that go out raw
+static std::vector<std::string> make_command(unsigned int seed) {
+    std::vector<std::string> frames;
+    for (unsigned int i = 0; i < 40; i++) {
+        bool random = i % 13 == 5 || i % 13 == 6;
+        size_t size = i % 7 == 3 ? 100 : PIPE_BUFFER_SIZE;
+        frames.push_back(random ? make_random(size, seed + i) : make_listing(size, seed + i % 4));
+    }
+    return frames;
+}
+
+static void round_trip_frames() {
+    compressor comp(codec_type::zlib);
+    decompressor decomp(codec_type::zlib);
+    std::vector<char> frame, raw;
+    for (unsigned int command = 0; command < 3; command++) {
+        for (const auto& data : make_command(command * 100)) {
+            codec_type type = comp.compress(data.data(), data.size(), frame);
+            if (type == codec_type::none) {
+                continue;
+            }
+            bool ok = decomp.decompress(frame.data(), frame.size(), data.size(), raw);
+            expect(ok && std::string(raw.begin(), raw.end()) == data, "frame did not round-trip");
+        }
+        comp.reset();
+        decomp.reset();
+    }
+
+    // the stream carries history across frames: a repeated frame within the
+    // 32 KiB window costs little
+    std::string data = make_listing(16384, 1);
+    comp.compress(data.data(), data.size(), frame);
+    size_t first = frame.size();
+    comp.compress(data.data(), data.size(), frame);
+    expect(frame.size() * 4 < first, "repeated frame was not compressed against the previous one ("
+           + std::to_string(frame.size()) + " vs " + std::to_string(first) + " bytes)");
+}
+
+static void round_trip_pipe() {
+    unlink(PIPE_PATH.c_str());
+    named_pipe::make_pipe(PIPE_PATH.c_str());
+    named_pipe reader(PIPE_PATH.c_str(), O_RDWR | O_NONBLOCK);
+    reader.set_codec(codec_type::zlib);
+    auto writer = named_pipe::open_writer(PIPE_PATH.c_str());
+    writer->set_codec(codec_type::zlib);
+
+    std::vector<std::string> expected;
+    for (unsigned int command = 0; command < 3; command++) {
+        std::string all;
+        for (const auto& data : make_command(command * 100 + 7)) {
+            all += data;
+        }
+        expected.push_back(all);
+    }
+    // longer than a message, on the middle command only
+    std::string trailer(600, 'c');
+    std::thread sender([&writer, &expected, &trailer] {
+        for (const auto& all : expected) {
+            for (size_t pos = 0; pos < all.size(); pos += 3000) {
+                writer->write_data(all.data() + pos, std::min<size_t>(3000, all.size() - pos));
+            }
+            writer->write_trailer(&all == &expected[1] ? trailer : std::string());
+            writer->finish();
+        }
+    });
+    for (const auto& all : expected) {
+        char* buf = nullptr;
+        size_t size = 0;
+        FILE* out = open_memstream(&buf, &size);
+        reader.pipe_to(out);
+        fclose(out);
+        expect(std::string(buf, size) == all, "command output did not round-trip through the pipe");
+        expect(reader.trailer() == (&all == &expected[1] ? trailer : std::string()), "trailer did not round-trip");
+        free(buf);
+    }
+    sender.join();
+    expect(writer->get_compressor()->total_out() < writer->get_compressor()->total_in(), "pipe output not compressed");
+    unlink(PIPE_PATH.c_str());
+}
+
+int main() {
+    round_trip_frames();
+    round_trip_pipe();
+    std::cout << "codec and named pipe round trip: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
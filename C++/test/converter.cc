@@ -0,0 +1,94 @@
+#include "converter.hh"
+#include "reference_converter.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+
+static const std::vector<std::string> EDGE_CASES = {
+    "", " ", "  ", "dir", "dir ", "dir  ", " dir", "DIR", "cd", "cd ", "cd  ", "cd \n", std::string("cd \0", 4),
+    "cd ..", "del", "del ", "move a b", "rename a b", "dir /s", "dir /S /B", "dir /b /s /on", "dir /o",
+    "dir /oN", "dir /ogne", "dir /ognex", "dir /opt", "dir /s /opt", "dir /o-d", "dir /O:-S",
+    "dir /og-n", "dir /o-g", "dir /o-", "dir /o:", "dir /oes /os", "dir /", "dir //", "dir /a /a /a",
+    "dir  /s  ", "dir C:\\ /s",
+    "ls -la", "echo dir", "dir\t/s", std::string("dir /\xc3\x89", 6), std::string("dir /\xff", 6)
+};
+
+static const std::vector<std::string> WORDS = {
+    "dir", "DIR", "cd", "del", "move", "rename", "ls", "echo", "/s", "/S", "/b", "/B", "/a", "/o", "/on",
+    "/o-d", "/ogne", "/opt", "/O:S", "/o-g", "/oge-d", "/", "/x", "..", ".", "C:\\", "a b", "\n",
+    std::string("\0", 1), "\t", "\xc3\xa9", "\xff"
+};
+
+static std::string generate(std::mt19937& rng) {
+    std::string command;
+    size_t words = rng() % 6;
+    for (size_t i = 0; i < words; i++) {
+        if (i > 0 || rng() % 8 == 0) {
+            command.append(1 + rng() % 3 / 2, ' ');
+        }
+        if (rng() % 10 == 0) {
+            for (size_t n = rng() % 6; n > 0; n--) {
+                command += static_cast<char>(rng() % 256);
+            }
+        } else {
+            command += WORDS[rng() % WORDS.size()];
+        }
+    }
+    if (rng() % 8 == 0) {
+        command += ' ';
+    }
+    return command;
+}
+
+static std::string escape(const std::string& s) {
+    std::string res;
+    for (unsigned char c : s) {
+        if (c < 0x20 || c >= 0x7f) {
+            static const char* HEX = "0123456789abcdef";
+            res += "\\x";
+            res += HEX[c >> 4];
+            res += HEX[c & 15];
+        } else {
+            res += c;
+        }
+    }
+    return res;
+}
+
+static bool check(const std::string& command, size_t& failures) {
+    for (bool cmd_format : { false, true }) {
+        converter conv(cmd_format);
+        std::string expected = reference_convert(command, cmd_format);
+        std::string actual = conv.convert(command);
+        std::string shared = convert(command, cmd_format);
+        if (actual != expected || shared != expected) {
+            std::cerr << "MISMATCH" << (cmd_format ? " (cmd format)" : "") << " on '" << escape(command) << "'\n"
+                      << "  reference: '" << escape(expected) << "'\n"
+                      << "  converter: '" << escape(actual) << "'\n"
+                      << "  convert(): '" << escape(shared) << "'" << std::endl;
+            failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+    unsigned int seed = argc > 2 ? std::stoul(argv[2]) : 20260101;
+    size_t failures = 0;
+
+    for (auto& command : EDGE_CASES) {
+        check(command, failures);
+    }
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < iterations && failures < 10; i++) {
+        check(generate(rng), failures);
+    }
+
+    std::cout << EDGE_CASES.size() << " edge cases and " << iterations << " generated inputs (seed " << seed << "): "
+              << (failures ? std::to_string(failures) + " mismatches" : std::string("identical")) << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
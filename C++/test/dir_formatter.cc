@@ -0,0 +1,84 @@
+#include "dir_formatter.hh"
+
+#include <iostream>
+#include <string>
+
+// does not exist, so the free space reads as 0
+static const std::string ROOT = "/tmp/lcc_test_dir_formatter";
+
+static const std::string LISTING =
+    ROOT + ":\n"
+    "total 24\n"
+    "drwxr-xr-x 2 root root     4096 2024-01-02 10:00 docs\n"
+    "-rw-r--r-- 1 root root  1234567 2024-01-03 11:30 big.bin\n"
+    "lrwxrwxrwx 1 root root        4 2024-01-04 12:00 link -> docs\n"
+    "crw-rw-rw- 1 root root   1,   3 2024-01-05 08:15 null\n"
+    "\n" +
+    ROOT + "/docs:\n"
+    "total 8\n"
+    "-rw-r--r-- 1 root root      999 2024-01-06 09:00 a b.txt\n"
+    "-rw-r--r-- 1 root root     1000 2024-01-07 09:01 c.txt\n";
+
+static const std::string EXPECTED =
+    " Directory of " + ROOT + "\n"
+    "\n"
+    "2024-01-02  10:00    <DIR>          docs\n"
+    "2024-01-03  11:30         1,234,567 big.bin\n"
+    "2024-01-04  12:00    <SYMLINK>      link [docs]\n"
+    "2024-01-05  08:15                 0 null\n"
+    "               3 File(s)      1,234,567 bytes\n"
+    "\n"
+    " Directory of " + ROOT + "/docs\n"
+    "\n"
+    "2024-01-06  09:00               999 a b.txt\n"
+    "2024-01-07  09:01             1,000 c.txt\n"
+    "               2 File(s)          1,999 bytes\n"
+    "\n"
+    "     Total Files Listed:\n"
+    "               5 File(s)      1,236,566 bytes\n"
+    "               1 Dir(s)               0 bytes free\n";
+
+static size_t failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << what << std::endl;
+        failures++;
+    }
+}
+
+static std::string format(const dir_options_t& options, size_t chunk) {
+    std::string out;
+    dir_formatter formatter(options, [&out](const char* data, size_t size) {
+        out.append(data, size);
+        return true;
+    });
+    for (size_t pos = 0; pos < LISTING.size(); pos += chunk) {
+        formatter.feed(LISTING.data() + pos, std::min(chunk, LISTING.size() - pos));
+    }
+    formatter.finish();
+    return out;
+}
+
+int main() {
+    dir_options_t options;
+    expect(dir_formatter::detect("ls -lR --time-style=long-iso " + ROOT, options)
+           && options.recursive && options.paths.size() == 1 && options.paths[0] == ROOT,
+           "recursive long-iso listing not detected");
+    dir_options_t plain;
+    expect(!dir_formatter::detect("ls -l " + ROOT, plain), "listing without long-iso times detected");
+
+    // line splits at every offset, including inside headers and numbers
+    size_t chunks = 0;
+    for (size_t chunk : { (size_t)1, (size_t)2, (size_t)3, (size_t)7, (size_t)13, (size_t)64, LISTING.size() }) {
+        std::string out = format(options, chunk);
+        if (out != EXPECTED) {
+            std::cerr << "fed in chunks of " << chunk << ":\n" << out << std::endl;
+            failures++;
+        }
+        chunks++;
+    }
+
+    std::cout << chunks << " chunk sizes formatted as cmd dir: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include "dir_lister.hh"
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const std::string ROOT = "/tmp/lcc_test_dir_lister";
+
+// enough directories that the listing runs past the dispatch window
+constexpr const int WIDE_DIRS = DIR_LISTER_WINDOW * 2;
+
+static void make_file(const std::string& path, size_t size, time_t mtime, long nsec = 0) {
+    int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    std::string data(size, 'x');
+    if (write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size())) {
+        perror("write");
+    }
+    struct timespec times[2] = { { mtime, nsec }, { mtime, nsec } };
+    futimens(fd, times);
+    close(fd);
+}
+
+static void make_tree() {
+    mkdir(ROOT.c_str(), 0755);
+    mkdir((ROOT + "/src").c_str(), 0755);
+    mkdir((ROOT + "/src/lib").c_str(), 0755);
+    mkdir((ROOT + "/src/lib/deep").c_str(), 0755);
+    mkdir((ROOT + "/Docs").c_str(), 0755);
+    mkdir((ROOT + "/wide").c_str(), 0755);
+    make_file(ROOT + "/b.txt", 30, 1000000000);
+    make_file(ROOT + "/a.cc", 10, 1000000300);
+    make_file(ROOT + "/C.hh", 20, 1000000200);
+    make_file(ROOT + "/README", 20, 1000000200, 500);
+    make_file(ROOT + "/.hidden", 5, 1000000100);
+    make_file(ROOT + "/src/main.cc", 100, 1100000000);
+    make_file(ROOT + "/src/main.o", 100, 1100000000);
+    make_file(ROOT + "/src/lib/util.hh", 1, 1200000000);
+    make_file(ROOT + "/src/lib/deep/x.y.z", 7, 1300000000);
+    make_file(ROOT + "/Docs/guide.md", 2000, 900000000);
+    if (symlink("src", (ROOT + "/link").c_str()) != 0) {
+        perror("symlink");
+    }
+    for (int i = WIDE_DIRS - 1; i >= 0; i--) {
+        std::string dir = ROOT + "/wide/d" + std::to_string(i);
+        mkdir(dir.c_str(), 0755);
+        mkdir((dir + "/sub").c_str(), 0755);
+        make_file(dir + "/sub/f" + std::to_string(i % 7), i, 1000000000 + i);
+    }
+}
+
+static std::string native(const std::string& command, unsigned int threads) {
+    dir_options_t options;
+    if (!dir_lister::parse(command, options)) {
+        return "<not parsed>";
+    }
+    std::string out;
+    dir_lister lister(options, threads);
+    lister.run([&out](const char* data, size_t size) {
+        out.append(data, size);
+        return true;
+    });
+    return out;
+}
+
+static std::string reference(const std::string& command) {
+    std::string out;
+    FILE* ls = popen(("LC_ALL=C " + command + " 2>/dev/null").c_str(), "r");
+    if (ls == nullptr) {
+        perror("popen");
+        return out;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), ls)) > 0) {
+        out.append(buf, n);
+    }
+    pclose(ls);
+    return out;
+}
+
+int main() {
+    const std::vector<std::string> COMMANDS = {
+        "ls -R", "ls -RU", "ls -R -S", "ls -R -t", "ls -R -X", "ls -R -r", "ls -R -t -r", "ls -R -S -U",
+        "ls -R --group-directories-first", "ls -R -X -r --group-directories-first", "ls -Ra", "ls -RA -t",
+        "ls -R -l --time-style=long-iso", "ls -RU -A -l --time-style=long-iso",
+        "ls -RA -l --time-style=long-iso --group-directories-first", "ls -R -S -r -l --time-style=long-iso"
+    };
+    setenv("LC_ALL", "C", 1);
+    system(("rm -rf " + ROOT).c_str());
+    make_tree();
+
+    size_t failures = 0;
+    for (const auto& options : COMMANDS) {
+        for (const std::string& paths : { ROOT, ROOT + "/src " + ROOT + "/b.txt " + ROOT + "/Docs " + ROOT + "/a.cc" }) {
+            std::string command = options + " " + paths;
+            std::string expected = reference(command);
+            for (unsigned int threads : { 1u, 4u }) {
+                std::string actual = native(command, threads);
+                if (actual != expected) {
+                    std::cerr << "MISMATCH (" << threads << " threads) on '" << command << "'\n"
+                              << "--- ls\n" << expected << "--- dir_lister\n" << actual << std::endl;
+                    failures++;
+                }
+            }
+        }
+    }
+    system(("rm -rf " + ROOT).c_str());
+
+    std::cout << COMMANDS.size() * 2 << " listings compared with ls: "
+              << (failures ? std::to_string(failures) + " mismatches" : std::string("identical")) << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
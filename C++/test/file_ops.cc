@@ -0,0 +1,103 @@
+#include "file_ops.hh"
+#include "uring.hh"
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const std::string ROOT = "/tmp/lcc_test_file_ops";
+
+// more files than the ring holds so submissions wrap and completions are capped
+constexpr const int FILES = 100;
+constexpr const unsigned int BATCH = 8;
+
+static size_t failures = 0;
+
+static void touch(const std::string& path) {
+    close(open(path.c_str(), O_CREAT | O_WRONLY, 0644));
+}
+
+static bool exists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+static std::string run(const std::string& command, bool use_uring, unsigned int threads) {
+    file_ops_options_t options;
+    if (!file_ops::parse(command, options)) {
+        return "<not parsed>";
+    }
+    std::string report;
+    file_ops ops(options, BATCH, threads, use_uring);
+    ops.run([&report](const char* data, size_t size) {
+        report.append(data, size);
+        return true;
+    });
+    return report;
+}
+
+static void expect(bool ok, const std::string& what, const std::string& mode) {
+    if (!ok) {
+        std::cerr << mode << ": " << what << std::endl;
+        failures++;
+    }
+}
+
+static void check(bool use_uring, unsigned int threads) {
+    std::string mode = std::string(use_uring ? "uring" : "threads") + " x" + std::to_string(threads);
+    system(("rm -rf " + ROOT).c_str());
+    mkdir(ROOT.c_str(), 0755);
+    mkdir((ROOT + "/dest").c_str(), 0755);
+
+    // every other file is missing, so results must land on the right op
+    std::string rm = "rm -v";
+    std::string expected;
+    for (int i = 0; i < FILES; i++) {
+        std::string path = ROOT + "/f" + std::to_string(i);
+        if (i % 2 == 0) {
+            touch(path);
+            expected += "removed '" + path + "'\n";
+        } else {
+            expected += "rm: cannot remove '" + path + "': No such file or directory\n";
+        }
+        rm += " " + path;
+    }
+    expect(run(rm, use_uring, threads) == expected, "rm report differs", mode);
+    for (int i = 0; i < FILES; i += 2) {
+        expect(!exists(ROOT + "/f" + std::to_string(i)), "f" + std::to_string(i) + " not removed", mode);
+    }
+
+    std::string mv = "mv -v -n";
+    expected.clear();
+    for (int i = 0; i < FILES; i++) {
+        std::string source = ROOT + "/m" + std::to_string(i);
+        std::string target = ROOT + "/dest/m" + std::to_string(i);
+        touch(source);
+        if (i % 3 == 0) {
+            touch(target);
+        } else {
+            expected += "renamed '" + source + "' -> '" + target + "'\n";
+        }
+        mv += " " + source;
+    }
+    expect(run(mv + " " + ROOT + "/dest", use_uring, threads) == expected, "mv report differs", mode);
+    for (int i = 0; i < FILES; i++) {
+        bool kept = i % 3 == 0;
+        expect(exists(ROOT + "/m" + std::to_string(i)) == kept, "m" + std::to_string(i) + " wrongly moved", mode);
+    }
+    system(("rm -rf " + ROOT).c_str());
+}
+
+int main() {
+    uring ring(BATCH);
+    bool available = ring.valid() && ring.supports(IORING_OP_UNLINKAT) && ring.supports(IORING_OP_RENAMEAT);
+    for (unsigned int threads : { 1u, 4u }) {
+        check(true, threads);
+        check(false, threads);
+    }
+    std::cout << "per-file results with io_uring " << (available ? "" : "(unavailable, fell back) ")
+              << "and threads: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
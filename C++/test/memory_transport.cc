@@ -0,0 +1,160 @@
+#include "memory_transport.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+constexpr const unsigned int PRODUCERS = 4;
+constexpr const unsigned int CONSUMERS = 3;
+constexpr const unsigned int MESSAGES = 5000;
+
+static std::atomic<size_t> failures{ 0 };
+
+static void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << what << std::endl;
+        failures++;
+    }
+}
+
+static void check_order() {
+    memory_transport mt;
+    long type;
+    long session;
+    std::string data;
+    long sent;
+
+    // a negative type takes the lowest type up to its absolute value first
+    mt.send(5, "b");
+    mt.send(3, "a");
+    mt.send(7, "c");
+    mt.send(5, "b2");
+    std::string order;
+    while (true) {
+        std::tie(type, std::ignore, data, std::ignore) = mt.receive_session(-6, false);
+        if (type == 0) {
+            break;
+        }
+        order += data + " ";
+    }
+    expect(order == "a b b2 ", "negative type receive order: " + order);
+    std::tie(type, data) = mt.receive(7);
+    expect(type == 7 && data == "c", "type above the negative limit was not left for an exact receive");
+
+    // an exact type skips lower types
+    mt.send(3, "x");
+    mt.send(5, "y");
+    std::tie(type, data) = mt.receive(5);
+    expect(type == 5 && data == "y", "exact receive took another type");
+    std::tie(type, data) = mt.receive(3);
+    expect(type == 3 && data == "x", "lower type lost by an exact receive");
+
+    // session and send time pass through; a passed-on message keeps its time
+    mt.send(4, "z", 42, 123);
+    std::tie(type, session, data, sent) = mt.receive_session(4);
+    expect(type == 4 && session == 42 && data == "z" && sent == 123, "session or send time not passed through");
+    long before = message_clock();
+    mt.send(4, "now", 42);
+    std::tie(std::ignore, std::ignore, std::ignore, sent) = mt.receive_session(4);
+    expect(sent >= before, "send time not stamped");
+}
+
+static void check_empty() {
+    memory_transport mt;
+    auto empty = std::make_tuple(0L, 0L, std::string(), 0L);
+    expect(mt.receive_session(4, false) == empty, "non-waiting receive of an unknown type returned a message");
+    expect(mt.receive_session(-10, false) == empty, "non-waiting negative receive on an empty transport returned a message");
+    mt.send(4, "once");
+    mt.receive(4);
+    expect(mt.receive_session(4, false) == empty, "non-waiting receive of a drained type returned a message");
+}
+
+static void check_wakeup() {
+    memory_transport mt;
+    std::string data;
+    std::thread receiver([&mt, &data] {
+        std::tie(std::ignore, data) = mt.receive(9);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    mt.send(9, "late");
+    receiver.join();
+    expect(data == "late", "waiting receiver not woken");
+}
+
+// every message of every producer reaches exactly one consumer
+static void check_mpmc() {
+    memory_transport mt;
+    std::vector<std::unique_ptr<std::atomic<unsigned int>[]>> seen;
+    for (unsigned int p = 0; p < PRODUCERS; p++) {
+        seen.emplace_back(new std::atomic<unsigned int>[MESSAGES]());
+    }
+    std::atomic<size_t> received{ 0 };
+    const long stop = -MESSAGE_TYPE_BACKEND_ACCEPTABLE;
+
+    std::vector<std::thread> consumers;
+    for (unsigned int c = 0; c < CONSUMERS; c++) {
+        consumers.emplace_back([&mt, &seen, &received, stop] {
+            while (true) {
+                long type;
+                long session;
+                std::string data;
+                std::tie(type, session, data, std::ignore) = mt.receive_session(MESSAGE_TYPE_BACKEND_ACCEPTABLE);
+                if (type == stop) {
+                    return;
+                }
+                unsigned long index = std::stoul(data);
+                if (session < 1 || session > (long)PRODUCERS || type != session_request_type(session) || index >= MESSAGES) {
+                    expect(false, "unexpected message " + std::to_string(type) + " '" + data + "'");
+                    continue;
+                }
+                seen[session - 1][index]++;
+                received++;
+            }
+        });
+    }
+    std::vector<std::thread> producers;
+    for (unsigned int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&mt, p] {
+            long session = p + 1;
+            for (unsigned int i = 0; i < MESSAGES; i++) {
+                mt.send(session_request_type(session), std::to_string(i), session);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    // stopped only once everything arrived, so the stop messages cannot
+    // overtake real ones
+    while (received < PRODUCERS * MESSAGES && failures == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (unsigned int c = 0; c < CONSUMERS; c++) {
+        mt.send(stop, "");
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    size_t wrong = 0;
+    for (auto& counts : seen) {
+        for (unsigned int i = 0; i < MESSAGES; i++) {
+            wrong += counts[i] != 1;
+        }
+    }
+    expect(wrong == 0, std::to_string(wrong) + " messages not received exactly once");
+}
+
+int main() {
+    check_order();
+    check_empty();
+    check_wakeup();
+    check_mpmc();
+    std::cout << PRODUCERS << " producers, " << CONSUMERS << " consumers, " << PRODUCERS * MESSAGES
+              << " messages, receive order and empty receives: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
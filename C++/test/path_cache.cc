@@ -0,0 +1,83 @@
+#include "path_cache.hh"
+
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const std::string ROOT = "/tmp/lcc_test_path_cache";
+
+static size_t failures = 0;
+
+static void expect(path_cache& paths, const std::string& name, const std::string& expected) {
+    std::string actual = paths.resolve(name);
+    if (actual != expected) {
+        std::cerr << "resolve('" << name << "') = '" << actual << "', expected '" << expected << "'" << std::endl;
+        failures++;
+    }
+}
+
+static void make_program(const std::string& path) {
+    close(open(path.c_str(), O_CREAT | O_WRONLY, 0755));
+}
+
+int main() {
+    system(("rm -rf " + ROOT).c_str());
+    mkdir(ROOT.c_str(), 0755);
+    mkdir((ROOT + "/bin").c_str(), 0755);
+    make_program(ROOT + "/bin/tool");
+
+    // "early" does not exist yet, so it cannot be watched
+    path_cache paths((ROOT + "/early:" + ROOT + "/bin").c_str());
+    expect(paths, "tool", ROOT + "/bin/tool");
+    expect(paths, "missing", "");
+
+    mkdir((ROOT + "/early").c_str(), 0755);
+    make_program(ROOT + "/early/tool");
+    make_program(ROOT + "/early/missing");
+    expect(paths, "tool", ROOT + "/early/tool");
+    expect(paths, "missing", ROOT + "/early/missing");
+
+    // now watched: cached, and still invalidated by changes
+    unsigned long probes = paths.total_probes();
+    expect(paths, "tool", ROOT + "/early/tool");
+    if (paths.total_probes() != probes) {
+        std::cerr << "lookup in watched directories was not cached" << std::endl;
+        failures++;
+    }
+    unlink((ROOT + "/early/tool").c_str());
+    expect(paths, "tool", ROOT + "/bin/tool");
+
+    // a removed and recreated directory is watched again
+    unlink((ROOT + "/early/missing").c_str());
+    rmdir((ROOT + "/early").c_str());
+    expect(paths, "missing", "");
+    mkdir((ROOT + "/early").c_str(), 0755);
+    make_program(ROOT + "/early/missing");
+    expect(paths, "missing", ROOT + "/early/missing");
+
+    // a moved directory is no longer what the PATH entry names
+    rename((ROOT + "/early").c_str(), (ROOT + "/moved").c_str());
+    expect(paths, "missing", "");
+    make_program(ROOT + "/moved/tool");
+    mkdir((ROOT + "/early").c_str(), 0755);
+    make_program(ROOT + "/early/tool");
+    expect(paths, "tool", ROOT + "/early/tool");
+
+    std::vector<std::string> args;
+    if (path_cache::simple_command("pwd", args) || !path_cache::simple_command("ls -l", args)) {
+        std::cerr << "shell builtins must go through the shell" << std::endl;
+        failures++;
+    }
+    if (!path_cache::plain_words("cd  /tmp", args) || args.size() != 2 || args[1] != "/tmp"
+        || path_cache::plain_words("cd $HOME", args)) {
+        std::cerr << "plain words split wrongly" << std::endl;
+        failures++;
+    }
+    system(("rm -rf " + ROOT).c_str());
+
+    std::cout << paths.total_hits() << " hits, " << paths.total_misses() << " misses, "
+              << paths.total_invalidations() << " invalidations: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
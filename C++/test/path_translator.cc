@@ -0,0 +1,61 @@
+#include "path_translator.hh"
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const std::string ROOT = "/tmp/lcc_test_path_translator";
+
+static size_t failures = 0;
+
+static void expect(path_translator& paths, const std::string& path, const std::string& expected) {
+    std::string actual = paths.translate(path);
+    if (actual != expected) {
+        std::cerr << "translate('" << path << "') = '" << actual << "', expected '" << expected << "'" << std::endl;
+        failures++;
+    }
+}
+
+static void touch(const std::string& path) {
+    close(open(path.c_str(), O_CREAT | O_WRONLY, 0644));
+}
+
+int main() {
+    mkdir(ROOT.c_str(), 0755);
+    mkdir((ROOT + "/Docs").c_str(), 0755);
+    mkdir((ROOT + "/Docs/Old").c_str(), 0755);
+    touch(ROOT + "/Docs/Report.TXT");
+    touch(ROOT + "/Docs/report.txt");
+
+    path_translator paths(ROOT);
+    expect(paths, "docs\\old", "Docs/Old");
+    expect(paths, "DOCS\\REPORT.TXT", "Docs/Report.TXT");
+    expect(paths, "docs\\report.txt", "Docs/report.txt");
+    expect(paths, ".\\docs\\..\\DOCS", "./Docs/../Docs");
+    expect(paths, "docs\\missing\\file", "Docs/missing/file");
+    expect(paths, "C:" + ROOT + "\\DOCS", ROOT + "/Docs");
+    expect(paths, "c:docs", "Docs");
+    expect(paths, "C:", "/");
+
+    // changes after the directory is cached must be visible
+    touch(ROOT + "/Docs/Later");
+    expect(paths, "docs\\later", "Docs/Later");
+    unlink((ROOT + "/Docs/Later").c_str());
+    expect(paths, "docs\\later", "Docs/later");
+    rename((ROOT + "/Docs/Old").c_str(), (ROOT + "/Docs/Archive").c_str());
+    expect(paths, "docs\\old", "Docs/old");
+    expect(paths, "docs\\archive", "Docs/Archive");
+
+    unlink((ROOT + "/Docs/Report.TXT").c_str());
+    unlink((ROOT + "/Docs/report.txt").c_str());
+    rmdir((ROOT + "/Docs/Archive").c_str());
+    rmdir((ROOT + "/Docs").c_str());
+    rmdir(ROOT.c_str());
+
+    std::cout << paths.total_loads() << " directory loads, " << paths.total_hits() << " hits, "
+              << paths.total_invalidations() << " invalidations: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
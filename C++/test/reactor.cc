@@ -0,0 +1,123 @@
+#include "reactor.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::atomic<size_t> failures{ 0 };
+
+static void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << what << std::endl;
+        failures++;
+    }
+}
+
+static task<int> square(int value) {
+    co_return value * value;
+}
+
+static task<int> sum_of_squares(int n) {
+    int sum = 0;
+    for (int i = 1; i <= n; i++) {
+        sum += co_await square(i);
+    }
+    co_return sum;
+}
+
+static task<int> fail() {
+    throw std::runtime_error("boom");
+    co_return 0;
+}
+
+static task<void> check_tasks(reactor& r) {
+    expect(co_await sum_of_squares(10) == 385, "nested tasks returned the wrong value");
+    bool caught = false;
+    try {
+        co_await fail();
+    } catch (const std::runtime_error& e) {
+        caught = std::string(e.what()) == "boom";
+    }
+    expect(caught, "exception did not reach the awaiting task");
+    co_await r.schedule();
+    expect(co_await square(3) == 9, "task after a reschedule returned the wrong value");
+}
+
+// one writer per pipe; the reader resumes through epoll only
+static task<void> read_pipe(reactor& r, int fd, size_t expected, std::atomic<size_t>& total) {
+    byte_stream in(r, fd);
+    size_t got = 0;
+    char buf[256];
+    size_t size;
+    while ((size = co_await in.read(buf, sizeof(buf))) > 0) {
+        got += size;
+    }
+    expect(got == expected, "pipe reader got " + std::to_string(got) + " of " + std::to_string(expected) + " bytes");
+    total += got;
+}
+
+static task<void> count(reactor& r, std::atomic<size_t>& done) {
+    co_await r.schedule();
+    done++;
+}
+
+int main() {
+    constexpr const size_t PIPES = 32;
+    constexpr const size_t BYTES = 100000;
+    constexpr const size_t TASKS = 10000;
+
+    for (unsigned int threads : { 1u, 4u }) {
+        reactor r;
+        r.spawn(check_tasks(r));
+
+        std::atomic<size_t> total{ 0 };
+        std::vector<int> writers;
+        for (size_t i = 0; i < PIPES; i++) {
+            int fds[2];
+            if (pipe2(fds, O_CLOEXEC) == -1) {
+                perror("pipe2");
+                return EXIT_FAILURE;
+            }
+            r.spawn(read_pipe(r, fds[0], BYTES, total));
+            writers.push_back(fds[1]);
+        }
+        std::thread feeder([&writers] {
+            std::string chunk(1000, 'x');
+            for (size_t sent = 0; sent < BYTES; sent += chunk.size()) {
+                for (int fd : writers) {
+                    if (write(fd, chunk.data(), chunk.size()) != (ssize_t)chunk.size()) {
+                        perror("write");
+                    }
+                }
+            }
+            for (int fd : writers) {
+                close(fd);
+            }
+        });
+
+        std::atomic<size_t> done{ 0 };
+        for (size_t i = 0; i < TASKS; i++) {
+            r.spawn(count(r, done));
+        }
+
+        std::vector<std::thread> runners;
+        for (unsigned int t = 1; t < threads; t++) {
+            runners.emplace_back([&r] { r.run(); });
+        }
+        r.run();
+        for (auto& t : runners) {
+            t.join();
+        }
+        feeder.join();
+        expect(total == PIPES * BYTES, "pipes were not read completely");
+        expect(done == TASKS, "only " + std::to_string(done.load()) + " of " + std::to_string(TASKS) + " tasks ran");
+    }
+
+    std::cout << "tasks, reactor scheduling and pipe reads: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
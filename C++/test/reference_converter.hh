@@ -0,0 +1,129 @@
+#ifndef __REFERENCE_CONVERTER_HH__
+#define __REFERENCE_CONVERTER_HH__
+
+#include <string>
+#include <cctype>
+
+inline bool reference_sort_flags(const std::string& flag, std::string& flags) {
+    std::string keys = flag.substr(2);
+    if (!keys.empty() && keys[0] == ':') {
+        keys = keys.substr(1);
+    }
+    if (keys.empty()) {
+        flags = " --group-directories-first";
+        return true;
+    }
+    char primary = 0;
+    bool reverse = false;
+    bool group = false;
+    for (size_t i = 0; i < keys.size(); i++) {
+        bool negated = false;
+        if (keys[i] == '-') {
+            negated = true;
+            i++;
+        }
+        if (i >= keys.size()) {
+            return false;
+        }
+        char key = keys[i];
+        if (key != 'n' && key != 's' && key != 'e' && key != 'd' && key != 'g') {
+            return false;
+        }
+        if (key == 'g') {
+            if (!negated) {
+                group = true;
+            }
+        } else if (primary == 0) {
+            primary = key;
+            reverse = negated;
+        }
+    }
+    flags = "";
+    if (primary == 'n' && reverse) {
+        flags = " -r";
+    } else if (primary == 's') {
+        flags = reverse ? " -S" : " -S -r";
+    } else if (primary == 'e') {
+        flags = reverse ? " -X -r" : " -X";
+    } else if (primary == 'd') {
+        flags = reverse ? " -t" : " -t -r";
+    }
+    if (group) {
+        flags += " --group-directories-first";
+    }
+    return true;
+}
+
+// The straightforward converter the optimized one in src/converter.cc must
+// match byte for byte. Keep it simple; do not optimize it.
+inline std::string reference_convert(const std::string& command, bool cmd_format) {
+    std::string cmd;
+    std::string args;
+    std::string::size_type pos = command.find(" ");
+    if (pos == std::string::npos) {
+        cmd = command;
+    } else {
+        cmd = command.substr(0, pos);
+        args = command.substr(pos + 1);
+    }
+
+    if (cmd == "dir") {
+        std::string res("ls");
+        bool bare = false;
+        std::string rest;
+        bool recursive = false;
+        bool sorted = false;
+        std::string sort;
+        pos = 0;
+        while (pos < args.size()) {
+            std::string::size_type end = args.find(' ', pos);
+            if (end == std::string::npos) {
+                end = args.size();
+            }
+            std::string token = args.substr(pos, end - pos);
+            pos = end + 1;
+
+            std::string flag;
+            for (auto c : token) {
+                flag += std::tolower(static_cast<unsigned char>(c));
+            }
+            if (flag == "/s") {
+                recursive = true;
+            } else if (flag == "/a") {
+                res += " -a";
+            } else if (flag == "/b") {
+                res += " -1";
+                bare = true;
+            } else if (flag.compare(0, 2, "/o") == 0 && reference_sort_flags(flag, sort)) {
+                sorted = true;
+            } else if (!token.empty()) {
+                rest += " " + token;
+            }
+        }
+        if (recursive) {
+            res += sorted ? " -R" : " -RU";
+        }
+        res += sort;
+        if (cmd_format && !bare) {
+            res += " -l --time-style=long-iso";
+        }
+        return res + rest;
+    }
+    if (cmd == "rename" || cmd == "move") {
+        return "mv " + args;
+    }
+    if (cmd == "del") {
+        return "rm " + args;
+    }
+    if (cmd == "cd") {
+        for (auto c : args) {
+            if (c != ' ' && c != '\n' && c != '\0') {
+                return "cd " + args;
+            }
+        }
+        return std::string("pwd");
+    }
+    return command;
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "scheduler.hh"
+#include "heavy_slots.hh"
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/wait.h>
+
+static size_t failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << what << std::endl;
+        failures++;
+    }
+}
+
+// the commands next() hands out, up to `limit`, finishing each one
+static std::string run(scheduler& sched, size_t limit = 64) {
+    std::string order;
+    sched_request_t req;
+    while (order.size() < limit && sched.next(req)) {
+        order += req.command.back();
+        sched.finish(req);
+    }
+    return order;
+}
+
+static void expect_class(const std::string& command, priority_class priority, bool heavy) {
+    bool actual_heavy;
+    priority_class actual = scheduler::classify(command, actual_heavy);
+    if (actual != priority || actual_heavy != heavy) {
+        std::cerr << "classify('" << command << "') = " << (actual == priority_class::batch ? "batch" : "interactive")
+                  << (actual_heavy ? ", heavy" : "") << std::endl;
+        failures++;
+    }
+}
+
+int main() {
+    expect_class("rm -r dir", priority_class::batch, true);
+    expect_class("rm -fr dir", priority_class::batch, true);
+    expect_class("cp -R a b", priority_class::batch, true);
+    expect_class("rm --recursive dir", priority_class::batch, true);
+    expect_class("rm my-report.txt", priority_class::batch, false);
+    expect_class("rm -- -r", priority_class::batch, false);
+    expect_class("rm --force x-r", priority_class::batch, false);
+    expect_class("rm *.o", priority_class::batch, true);
+    expect_class("find .", priority_class::batch, true);
+    expect_class("ls -R", priority_class::batch, true);
+    expect_class("ls -lR dir", priority_class::batch, true);
+    expect_class("ls -l my-Reports", priority_class::interactive, false);
+    expect_class("ls", priority_class::interactive, false);
+    expect_class("echo -r", priority_class::interactive, false);
+
+    // the wait is measured from the send time, not from when the request is queued
+    scheduler sched;
+    sched.push(1, "echo a", sched_clock::now() - std::chrono::milliseconds(50));
+    sched_request_t req;
+    if (!sched.next(req) || sched.stats(priority_class::interactive).max_wait_us < 50000) {
+        std::cerr << "wait not measured from the send time: "
+                  << sched.stats(priority_class::interactive).max_wait_us << "us" << std::endl;
+        failures++;
+    }
+
+    // deficit round robin: two busy sessions alternate a quantum at a time
+    scheduler fair;
+    for (int i = 0; i < 8; i++) {
+        fair.push(1, "echo a");
+        fair.push(2, "echo b");
+    }
+    std::string order = run(fair);
+    expect(order == "aaaabbbbaaaabbbb", "round robin order " + order);
+
+    // interactive requests go first unless batch work has waited too long
+    scheduler priority;
+    priority.push(1, "rm x");
+    priority.push(2, "echo i");
+    order = run(priority);
+    expect(order == "ix", "interactive request not dispatched first: " + order);
+
+    scheduler aging;
+    aging.push(1, "rm x", sched_clock::now() - std::chrono::milliseconds(SCHEDULER_BATCH_MAX_WAIT_MS + 10));
+    aging.push(2, "echo i");
+    order = run(aging);
+    expect(order == "xi", "aged batch request not dispatched first: " + order);
+
+    // heavy requests beyond the cap wait; other work runs past them
+    scheduler capped(SCHEDULER_QUANTUM, 1);
+    capped.push(1, "rm -r a");
+    capped.push(2, "rm -r b");
+    capped.push(3, "rm c");
+    sched_request_t first;
+    sched_request_t second;
+    expect(capped.next(first) && first.command == "rm -r a", "first heavy request not dispatched");
+    expect(capped.next(second) && second.command == "rm c", "light request not dispatched past the cap");
+    expect(!capped.next(req) && !capped.empty(), "heavy request dispatched beyond the cap");
+    capped.finish(second);
+    capped.finish(first);
+    expect(capped.next(req) && req.command == "rm -r b", "heavy request not dispatched after finish");
+    capped.finish(req);
+
+    // the cap holds across schedulers sharing the slots, and a dead
+    // holder's slot is freed
+    heavy_slots slots(IPC_PRIVATE, 1);
+    scheduler left(SCHEDULER_QUANTUM, 1, &slots);
+    scheduler right(SCHEDULER_QUANTUM, 1, &slots);
+    left.push(1, "find .");
+    right.push(2, "ls -R");
+    expect(left.next(first), "shared heavy slot not taken");
+    expect(!right.next(second), "shared heavy cap exceeded");
+    left.finish(first);
+    expect(right.next(second) && slots.holding() == 1, "shared heavy slot not freed by finish");
+    right.finish(second);
+
+    int ready[2];
+    int done[2];
+    if (pipe(ready) == 0 && pipe(done) == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(done[1]);
+            char c = slots.try_acquire() ? 'y' : 'n';
+            (void)!write(ready[1], &c, 1);
+            (void)!read(done[0], &c, 1);
+            _exit(EXIT_SUCCESS);
+        }
+        char c = 'n';
+        (void)!read(ready[0], &c, 1);
+        expect(c == 'y' && !slots.try_acquire(), "slot not held by another process");
+        close(done[1]);
+        waitpid(pid, nullptr, 0);
+        expect(slots.try_acquire(), "slot of an exited process not freed");
+        slots.release();
+    }
+    slots.destroy();
+
+    // a stopping backend takes back everything still queued
+    scheduler stopping;
+    stopping.push(1, "echo a");
+    stopping.push(1, "rm b");
+    stopping.push(2, "echo c");
+    auto drained = stopping.drain();
+    order.clear();
+    for (const auto& request : drained) {
+        order += request.command.back();
+    }
+    expect(order == "acb" && stopping.empty() && !stopping.next(req), "drain returned " + order);
+
+    std::cout << "scheduler classification, fairness, heavy cap and wait: " << (failures ? "FAILED" : "ok") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}